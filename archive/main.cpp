@@ -0,0 +1,141 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// archive/main.cpp
+// compresses capture files for archiving and decodes them again
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "capturefile.h"
+#include "tracecodec.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <cstdio>
+#include <cstring>
+
+static int compress(const QString &captureName, const QString &traceName)
+{
+    CaptureReader capture;
+    if (!capture.open(captureName)) {
+        fprintf(stderr, "%s\n", qPrintable(capture.errorString()));
+        return 1;
+    }
+    const CAPTURE_HEADER &ch = capture.header();
+    TRACE_HEADER th;
+    memset(&th, 0, sizeof(th));
+    memcpy(th.magic, TRACE_MAGIC, sizeof(th.magic));
+    th.version = TRACE_VERSION;
+    th.voltageScale = ch.voltageScale;
+    th.currentScale = ch.currentScale;
+    th.minU = ch.minU;
+    th.minI = ch.minI;
+    th.maxU = ch.maxU;
+    th.maxI = ch.maxI;
+    th.startMs = ch.startMs;
+    th.count = capture.count();
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data;
+    data.reserve(static_cast<int>(qMin<quint64>(capture.count()*2, 0x40000000)));
+    TraceEncoder encoder(data);
+    for (quint64 n = 0; n < capture.count(); ++n) {
+        const CAPTURE_RECORD &r = capture.record(n);
+        encoder.append(CaptureReader::timeMs(r), r.u, r.i, (r.t & CAPTURE_CC_FLAG) != 0);
+    }
+    encoder.finish();
+    const qint64 encodeNs = timer.nsecsElapsed();
+
+    QFile out(traceName);
+    if (!out.open(QFile::WriteOnly | QFile::Truncate)
+            || (out.write(reinterpret_cast<const char*>(&th), sizeof(th)) != sizeof(th))
+            || (out.write(data) != data.size())) {
+        fprintf(stderr, "cannot write %s: %s\n", qPrintable(traceName), qPrintable(out.errorString()));
+        return 1;
+    }
+    const double raw = static_cast<double>(capture.count())*sizeof(CAPTURE_RECORD);
+    printf("%llu samples, %.0f -> %d bytes (%.2f bytes/sample, %.1f:1) in %.1f ms\n",
+           static_cast<unsigned long long>(capture.count()), raw, data.size(),
+           capture.count() ? static_cast<double>(data.size())/capture.count() : 0.,
+           data.size() ? raw/data.size() : 0., encodeNs/1e6);
+    return 0;
+}
+
+static int decode(const QString &traceName, const QString &csvName)
+{
+    QFile in(traceName);
+    if (!in.open(QFile::ReadOnly)) {
+        fprintf(stderr, "cannot open %s: %s\n", qPrintable(traceName), qPrintable(in.errorString()));
+        return 1;
+    }
+    const qint64 size = in.size();
+    const uchar *map = in.map(0, size);
+    TRACE_HEADER th;
+    if ((map == nullptr) || (size < static_cast<qint64>(sizeof(th)))) {
+        fprintf(stderr, "cannot read %s\n", qPrintable(traceName));
+        return 1;
+    }
+    memcpy(&th, map, sizeof(th));
+    if ((memcmp(th.magic, TRACE_MAGIC, sizeof(th.magic)) != 0) || (th.version != TRACE_VERSION)) {
+        fprintf(stderr, "%s is not a trace file\n", qPrintable(traceName));
+        return 1;
+    }
+
+    // time the decoder alone before writing the text output
+    QElapsedTimer timer;
+    timer.start();
+    quint32 t;
+    quint16 u, i;
+    bool cc;
+    quint64 count = 0;
+    TraceDecoder decoder(reinterpret_cast<const char*>(map) + sizeof(th), size - sizeof(th));
+    while (decoder.next(t, u, i, cc))
+        count++;
+    const qint64 decodeNs = timer.nsecsElapsed();
+    if (decoder.hasError() || (count != th.count))
+        fprintf(stderr, "warning: %llu of %llu samples decoded\n", static_cast<unsigned long long>(count), static_cast<unsigned long long>(th.count));
+    printf("%llu samples decoded in %.1f ms\n", static_cast<unsigned long long>(count), decodeNs/1e6);
+
+    if (csvName.isEmpty())
+        return 0;
+    FILE *csv = fopen(QFile::encodeName(csvName).constData(), "w");
+    if (csv == nullptr) {
+        fprintf(stderr, "cannot create %s\n", qPrintable(csvName));
+        return 1;
+    }
+    fprintf(csv, "t_ms,voltage_V,current_A,cc\n");
+    TraceDecoder rows(reinterpret_cast<const char*>(map) + sizeof(th), size - sizeof(th));
+    while (rows.next(t, u, i, cc))
+        fprintf(csv, "%u,%.4f,%.4f,%d\n", t, static_cast<double>(u)/th.voltageScale, static_cast<double>(i)/th.currentScale, cc ? 1 : 0);
+    fclose(csv);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("mp7archive");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compresses MP7100 capture files (.mp7cap) into traces (.mp7trc) and decodes them again.");
+    parser.addHelpOption();
+    QCommandLineOption decodeOption(QStringList() << "d" << "decode", "Decode a trace, optionally into a CSV file.");
+    parser.addOption(decodeOption);
+    parser.addPositionalArgument("input", "Capture file to compress or trace file to decode.");
+    parser.addPositionalArgument("output", "Trace file, or CSV file when decoding.");
+    parser.process(a);
+    const QStringList args = parser.positionalArguments();
+    if (parser.isSet(decodeOption)) {
+        if (args.isEmpty())
+            parser.showHelp(1);
+        return decode(args.at(0), args.value(1));
+    }
+    if (args.size() != 2)
+        parser.showHelp(1);
+    return compress(args.at(0), args.at(1));
+}
@@ -0,0 +1,17 @@
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = mp7archive
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ../capturefile.cpp
+
+HEADERS += \
+    ../capturefile.h \
+    ../mp7100protocol.h \
+    ../tracecodec.h
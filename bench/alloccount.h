@@ -0,0 +1,79 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// bench/alloccount.h, header file
+// heap allocation counter of the benchmarks
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+// Counts the calls of malloc(), calloc() and realloc(). Qt allocates the
+// storage of QByteArray, QString and QList with malloc() and not with
+// operator new, so replacing operator new would miss them. The functions
+// of the C library are replaced by the executable, which requires glibc;
+// elsewhere allocCountAvailable() is false and no allocations are counted.
+// Include this header in exactly one source file of a benchmark.
+// ***************************************************************************
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+}
+
+static std::atomic<quint64> allocTotal(0);
+static thread_local quint64 allocThread = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    allocTotal.fetch_add(1, std::memory_order_relaxed);
+    allocThread++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    allocTotal.fetch_add(1, std::memory_order_relaxed);
+    allocThread++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    allocTotal.fetch_add(1, std::memory_order_relaxed);
+    allocThread++;
+    return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p)
+{
+    __libc_free(p);
+}
+
+static inline bool allocCountAvailable() { return true; }
+// allocations of all threads
+static inline quint64 allocCount() { return allocTotal.load(std::memory_order_relaxed); }
+// allocations of the calling thread
+static inline quint64 allocCountThread() { return allocThread; }
+
+#else
+
+static inline bool allocCountAvailable() { return false; }
+static inline quint64 allocCount() { return 0; }
+static inline quint64 allocCountThread() { return 0; }
+
+#endif
+
+#endif // ALLOCCOUNT_H
@@ -0,0 +1,14 @@
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = loggerbench
+
+include(../../tlog.pri)
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../alloccount.h
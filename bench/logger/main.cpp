@@ -0,0 +1,81 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// bench/logger/main.cpp
+// microbenchmark: cost of a log call in the caller's thread
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+// Compares formatting every message with a time stamp, as the former
+// _TMessageHandler() did in the caller's thread, with TMessageHandler::
+// addMessage() without a logger (identical messages are only counted),
+// TLogger::log() and a structured TLOG() record. The message text is
+// prepared once, as qInfo() passes it to the message handler. Prints time
+// and heap allocations of the caller's thread per message.
+// ***************************************************************************
+#include "tlog.h"
+#include "tlogger.h"
+#include "tmessagehandler.h"
+#include "../alloccount.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+
+template<typename F>
+static void run(const char *name, F log, int count)
+{
+    const quint64 allocs = allocCountThread();
+    QElapsedTimer t;
+    t.start();
+    for (int n = 0; n < count; ++n)
+        log();
+    const qint64 ns = t.nsecsElapsed();
+    printf("%-14s %8.1f ns/message %6.2f allocs/message\n", name,
+           static_cast<double>(ns)/count, static_cast<double>(allocCountThread() - allocs)/count);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    // the queue of the logger must not overflow
+    int count = 4000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (count <= 0)
+        count = 4000;
+    const QString msg("send: GETD");
+    printf("logging \"%s\" %d times\n", qPrintable(msg), count);
+    if (!allocCountAvailable())
+        printf("heap allocations are only counted with glibc\n");
+
+    // the messages are not saved
+    const QString noFile;
+    // the formatting the former _TMessageHandler() did for every message
+    QString line;
+    run("render", [&]() { line = TLog::render(TLog::text(QtInfoMsg, msg)); }, count);
+
+    // collation in the caller's thread, as _TMessageHandler() does without a
+    // logger. The repeated message is only counted, not formatted.
+    TMessageHandler handler(noFile);
+    run("addMessage", [&]() { handler.addMessage(TLog::text(QtInfoMsg, msg)); }, count);
+
+    TMessageHandler asyncHandler(noFile);
+    TLogger logger(&asyncHandler);
+    logger.start();
+    run("TLogger::log", [&]() { logger.log(QtInfoMsg, msg); }, count);
+    logger.stop();
+    if (logger.dropped() > 0)
+        printf("%u messages dropped, use a smaller count\n", logger.dropped());
+
+    TMessageHandler structuredHandler(noFile);
+    TLogger structuredLogger(&structuredHandler);
+    structuredLogger.start();
+    run("TLOG", [&]() { TLOG(QtInfoMsg, "send: %1", "GETD"); }, count);
+    structuredLogger.stop();
+    return 0;
+}
@@ -0,0 +1,175 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// bench/protocol/main.cpp
+// protocol throughput and latency benchmark
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+// Sends commands through MP7100 one after the other (closed loop) to a real
+// device or to the emulator and reports per command type: commands per
+// second, round trip percentiles, bytes on the wire and heap allocations of
+// all threads.
+// --csv prints one line per command type for comparing different commits.
+// ***************************************************************************
+#include "mp7100.h"
+#include "../alloccount.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+typedef struct {
+    const char              *name;
+    std::function<bool(MP7100 &dev, const MP7100::Callback &done)> issue;
+    QVector<qint64>         rttNs;
+    quint64                 failed;
+    quint64                 bytes;
+    quint64                 allocs;
+} COMMAND_STATS;
+
+static double percentileMs(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0.;
+    int inx = static_cast<int>(p*(sorted.size()-1) + 0.5);
+    return sorted[inx]/1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("MP7100 protocol throughput and latency benchmark.");
+    parser.addHelpOption();
+    QCommandLineOption portOption(QStringList() << "p" << "port", "Serial port of the device or emulator.", "port");
+    QCommandLineOption countOption("count", "Measured commands per command type.", "n", "1000");
+    QCommandLineOption warmupOption("warmup", "Unmeasured commands sent first.", "n", "20");
+    QCommandLineOption commandsOption("commands", "Comma separated command types (GETD,GETS,GOUT,GMIN,GMAX,SETD,SOUT).", "list", "GETD,GETS,GOUT");
+    QCommandLineOption labelOption("label", "Label of this run, e.g. a commit id.", "text", "-");
+    QCommandLineOption csvOption("csv", "Print comma separated values.");
+    parser.addOption(portOption);
+    parser.addOption(countOption);
+    parser.addOption(warmupOption);
+    parser.addOption(commandsOption);
+    parser.addOption(labelOption);
+    parser.addOption(csvOption);
+    parser.process(a);
+    if (!parser.isSet(portOption)) {
+        fprintf(stderr, "no port given, see --help\n");
+        return 1;
+    }
+
+    QVector<COMMAND_STATS> all = {
+        { "GETD", [](MP7100 &d, const MP7100::Callback &cb) { return d.getDisplayVoltageCurrent(cb); }, {}, 0, 0, 0 },
+        { "GETS", [](MP7100 &d, const MP7100::Callback &cb) { return d.getSetVoltageCurrent(cb); }, {}, 0, 0, 0 },
+        { "GOUT", [](MP7100 &d, const MP7100::Callback &cb) { return d.getOnOff(cb); }, {}, 0, 0, 0 },
+        { "GMIN", [](MP7100 &d, const MP7100::Callback &cb) { return d.getMinimumVoltageCurrent(cb); }, {}, 0, 0, 0 },
+        { "GMAX", [](MP7100 &d, const MP7100::Callback &cb) { return d.getMaximumVoltageCurrent(cb); }, {}, 0, 0, 0 },
+        { "SETD", [](MP7100 &d, const MP7100::Callback &cb) { return d.setVoltageCurrent(5., 0.1, cb); }, {}, 0, 0, 0 },
+        { "SOUT", [](MP7100 &d, const MP7100::Callback &cb) { return d.setOnOff(true, cb); }, {}, 0, 0, 0 },
+    };
+    QVector<COMMAND_STATS> stats;
+    for (const QString &name : parser.value(commandsOption).split(',')) {
+        auto it = std::find_if(all.begin(), all.end(), [&](const COMMAND_STATS &s) { return name.trimmed() == s.name; });
+        if (it == all.end()) {
+            fprintf(stderr, "unknown command type %s\n", qPrintable(name));
+            return 1;
+        }
+        stats.append(*it);
+    }
+    if (stats.isEmpty())
+        return 1;
+    const int count = qMax(1, parser.value(countOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int total = warmup + count*stats.size();
+    for (auto &s : stats)
+        s.rttNs.reserve(count);
+
+    MP7100 dev(parser.value(portOption));
+    if (!dev.open()) {
+        fprintf(stderr, "cannot open %s\n", qPrintable(parser.value(portOption)));
+        return 1;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 startNs = 0;
+    quint64 startAllocs = 0, startTx = 0, startRx = 0;
+    int issued = 0;
+    std::function<void()> issueNext;
+    issueNext = [&]() {
+        if (issued >= total) {
+            QTimer::singleShot(0, &a, &QCoreApplication::quit);
+            return;
+        }
+        const int n = issued++;
+        if (n == warmup) {
+            startNs = clock.nsecsElapsed();
+            startAllocs = allocCount();
+            startTx = dev.txBytes();
+            startRx = dev.rxBytes();
+        }
+        COMMAND_STATS &s = stats[n % stats.size()];
+        const bool measured = n >= warmup;
+        const quint64 bytes0 = dev.txBytes() + dev.rxBytes();
+        const quint64 allocs0 = allocCount();
+        const qint64 t0 = clock.nsecsElapsed();
+        s.issue(dev, [&, measured, bytes0, allocs0, t0](const MP7100::REPLY &reply) {
+            if (measured) {
+                if (reply.ok) {
+                    s.rttNs.append(clock.nsecsElapsed() - t0);
+                } else {
+                    s.failed++;
+                }
+                s.bytes += dev.txBytes() + dev.rxBytes() - bytes0;
+                s.allocs += allocCount() - allocs0;
+            }
+            issueNext();
+        });
+    };
+    QTimer::singleShot(0, &a, [&]() { issueNext(); });
+    a.exec();
+
+    const double seconds = (clock.nsecsElapsed() - startNs)/1e9;
+    const quint64 allocs = allocCount() - startAllocs;
+    const quint64 bytes = dev.txBytes() - startTx + dev.rxBytes() - startRx;
+    const QByteArray label = parser.value(labelOption).toLatin1();
+    const bool csv = parser.isSet(csvOption);
+    if (csv) {
+        printf("label,command,count,failed,cmds_per_s,p50_ms,p99_ms,p999_ms,bytes_per_cmd,allocs_per_cmd\n");
+    } else {
+        printf("run %s on %s, %d commands per type\n", label.constData(), qPrintable(parser.value(portOption)), count);
+        if (!allocCountAvailable())
+            printf("heap allocations are only counted with glibc\n");
+        printf("%-6s %7s %6s %9s %8s %8s %8s %9s %10s\n", "cmd", "count", "failed", "cmd/s", "p50 ms", "p99 ms", "p999 ms", "bytes/cmd", "allocs/cmd");
+    }
+    for (auto &s : stats) {
+        std::sort(s.rttNs.begin(), s.rttNs.end());
+        qint64 sum = 0;
+        for (qint64 rtt : s.rttNs)
+            sum += rtt;
+        const quint64 n = static_cast<quint64>(s.rttNs.size()) + s.failed;
+        const double perSecond = sum > 0 ? s.rttNs.size()/(sum/1e9) : 0.;
+        const double bytesPerCmd = n ? static_cast<double>(s.bytes)/n : 0.;
+        const double allocsPerCmd = n ? static_cast<double>(s.allocs)/n : 0.;
+        printf(csv ? "%s,%s,%llu,%llu,%.1f,%.3f,%.3f,%.3f,%.1f,%.2f\n"
+                   : "%.0s%-6s %7llu %6llu %9.1f %8.3f %8.3f %8.3f %9.1f %10.2f\n",
+               label.constData(), s.name, n, static_cast<unsigned long long>(s.failed), perSecond,
+               percentileMs(s.rttNs, 0.5), percentileMs(s.rttNs, 0.99), percentileMs(s.rttNs, 0.999),
+               bytesPerCmd, allocsPerCmd);
+    }
+    const double cmds = count*stats.size();
+    printf(csv ? "%s,total,%.0f,,%.1f,,,,%.1f,%.2f\n"
+               : "%.0stotal: %.0f commands, %.1f cmd/s, %.1f bytes/cmd, %.2f allocs/cmd\n",
+           label.constData(), cmds, cmds/seconds, bytes/cmds, allocs/cmds);
+    return 0;
+}
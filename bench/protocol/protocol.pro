@@ -0,0 +1,15 @@
+QT       -= gui
+QT       += serialport
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = protocolbench
+
+include(../../mp7100device.pri)
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../alloccount.h
@@ -0,0 +1,87 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// bench/replyparser/main.cpp
+// microbenchmark: cost of decoding a single GETD data line
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+// Compares the former QByteArray::split()/toUInt() decoding with
+// MP7100Protocol::parseFields(). Prints time and heap allocations per reply.
+// ***************************************************************************
+#include "mp7100protocol.h"
+#include "../alloccount.h"
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QList>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+
+static const char reply[] = "1234;0567;1";
+static const int replySize = sizeof(reply) - 1;
+
+// the decoding as it was done in MP7100::decodeCommand() before
+static quint32 decodeLegacy()
+{
+    const QByteArray buffer = QByteArray::fromRawData(reply, replySize);
+    QList<QByteArray> params = buffer.split(';');
+    double u = 0., i = 0.;
+    bool cc = false;
+    if (params.size()>0)
+        u = params[0].toUInt()/100.;
+    if (params.size()>1)
+        i = params[1].toUInt()/1000.;
+    if (params.size()>2)
+        cc = params[2]=="1";
+    bool ok = buffer.left(2)=="OK";
+    return static_cast<quint32>(u*100 + i*1000) + (cc ? 1 : 0) + (ok ? 1 : 0);
+}
+
+static quint32 decodeFields()
+{
+    quint32 values[3];
+    if (!MP7100Protocol::parseFields(reply, replySize, values, 3))
+        return 0;
+    bool ok = MP7100Protocol::isOk(reply, replySize);
+    return values[0] + values[1] + (values[2] == 1 ? 1 : 0) + (ok ? 1 : 0);
+}
+
+template<typename F>
+static void run(const char *name, F decode, int count)
+{
+    volatile quint32 sink = 0;
+    // warm up
+    for (int n = 0; n < count/10; ++n)
+        sink += decode();
+    quint64 allocs = allocCount();
+    QElapsedTimer t;
+    t.start();
+    for (int n = 0; n < count; ++n)
+        sink += decode();
+    qint64 ns = t.nsecsElapsed();
+    allocs = allocCount() - allocs;
+    printf("%-14s %8.1f ns/reply %6.2f allocs/reply\n", name,
+           static_cast<double>(ns)/count, static_cast<double>(allocs)/count);
+    Q_UNUSED(sink)
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    int count = 1000000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (count <= 0)
+        count = 1000000;
+    printf("decoding \"%s\" %d times\n", reply, count);
+    if (!allocCountAvailable())
+        printf("heap allocations are only counted with glibc\n");
+    run("split/toUInt", decodeLegacy, count);
+    run("parseFields", decodeFields, count);
+    return 0;
+}
@@ -0,0 +1,15 @@
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = replyparserbench
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../alloccount.h \
+    ../../mp7100protocol.h
@@ -0,0 +1,287 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// capturefile.cpp
+// memory mapped binary capture files of measured values
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "capturefile.h"
+#include <QDateTime>
+#include <QDebug>
+#include <atomic>
+#include <cstring>
+
+static_assert(sizeof(CAPTURE_HEADER) == 72, "capture header layout changed");
+static_assert(sizeof(CAPTURE_HEADER) <= CaptureFile::INDEX_OFFSET, "capture header overlaps the index");
+static_assert(sizeof(CAPTURE_RECORD) == 8, "capture record layout changed");
+
+
+quint64 CaptureFile::loadCount(const uchar *map)
+{
+    // aligned 64 bit access, the records are read after the count
+    const quint64 count = *reinterpret_cast<const volatile quint64*>(&reinterpret_cast<const CAPTURE_HEADER*>(map)->count);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return count;
+}
+
+void CaptureFile::storeCount(uchar *map, quint64 count)
+{
+    // the records must be visible before the count
+    std::atomic_thread_fence(std::memory_order_release);
+    *reinterpret_cast<volatile quint64*>(&reinterpret_cast<CAPTURE_HEADER*>(map)->count) = count;
+}
+
+quint32 CaptureFile::loadMarkCount(const uchar *map)
+{
+    const quint32 count = *reinterpret_cast<const volatile quint32*>(&reinterpret_cast<const CAPTURE_HEADER*>(map)->markCount);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return count;
+}
+
+void CaptureFile::storeMarkCount(uchar *map, quint32 count)
+{
+    std::atomic_thread_fence(std::memory_order_release);
+    *reinterpret_cast<volatile quint32*>(&reinterpret_cast<CAPTURE_HEADER*>(map)->markCount) = count;
+}
+
+
+CaptureWriter::CaptureWriter()
+    : m_map(nullptr)
+    , m_capacity(0)
+    , m_count(0)
+    , m_markCount(0)
+    , m_started(false)
+    , m_t0Ns(0)
+    , m_voltageScale(1)
+    , m_currentScale(1)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &fileName, const MP7100Protocol::MODEL &model, const LIMITS &limits)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::ReadWrite | QFile::Truncate))
+        return false;
+    m_count = 0;
+    m_markCount = 0;
+    m_started = false;
+    m_capacity = 0;
+    m_voltageScale = model.voltageScale;
+    m_currentScale = model.currentScale;
+    if (!grow()) {
+        m_file.close();
+        return false;
+    }
+    CAPTURE_HEADER *h = reinterpret_cast<CAPTURE_HEADER*>(m_map);
+    memcpy(h->magic, CAPTURE_MAGIC, sizeof(h->magic));
+    h->version = CAPTURE_VERSION;
+    h->headerSize = HEADER_SIZE;
+    h->recordSize = sizeof(CAPTURE_RECORD);
+    h->indexInterval = INDEX_INTERVAL;
+    h->indexCapacity = INDEX_CAPACITY;
+    h->voltageScale = model.voltageScale;
+    h->currentScale = model.currentScale;
+    h->minU = static_cast<quint32>(qMax(0., limits.minU)*model.voltageScale + 0.5);
+    h->minI = static_cast<quint32>(qMax(0., limits.minI)*model.currentScale + 0.5);
+    h->maxU = static_cast<quint32>(qMax(0., limits.maxU)*model.voltageScale + 0.5);
+    h->maxI = static_cast<quint32>(qMax(0., limits.maxI)*model.currentScale + 0.5);
+    h->startMs = QDateTime::currentMSecsSinceEpoch();
+    storeMarkCount(m_map, 0);
+    storeCount(m_map, 0);
+    return true;
+}
+
+bool CaptureWriter::grow()
+{
+    // the file can't be resized while it is mapped
+    if (m_map != nullptr) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    const qint64 size = HEADER_SIZE + static_cast<qint64>(m_capacity + CHUNK_RECORDS)*sizeof(CAPTURE_RECORD);
+    if (!m_file.resize(size))
+        return false;
+    m_map = m_file.map(0, size);
+    if (m_map == nullptr)
+        return false;
+    m_capacity += CHUNK_RECORDS;
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if (!m_file.isOpen())
+        return;
+    if (m_map != nullptr) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    // drop the preallocated space
+    m_file.resize(HEADER_SIZE + static_cast<qint64>(m_count)*sizeof(CAPTURE_RECORD));
+    m_file.close();
+}
+
+bool CaptureWriter::append(qint64 tNs, double u, double i, bool cc)
+{
+    if (m_map == nullptr)
+        return false;
+    const qint64 ms = toMs(tNs);
+    if (ms > CAPTURE_TIME_MASK) {
+        qWarning() << "capture file time range exceeded" << m_file.fileName();
+        return false;
+    }
+    if ((m_count == m_capacity) && !grow()) {
+        qWarning() << "cannot grow capture file" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    CAPTURE_RECORD &r = reinterpret_cast<CAPTURE_RECORD*>(m_map + HEADER_SIZE)[m_count];
+    r.t = static_cast<quint32>(ms) | (cc ? CAPTURE_CC_FLAG : 0);
+    r.u = static_cast<quint16>(qBound(0., u*m_voltageScale + 0.5, 65535.));
+    r.i = static_cast<quint16>(qBound(0., i*m_currentScale + 0.5, 65535.));
+    if (((m_count % INDEX_INTERVAL) == 0) && (m_count/INDEX_INTERVAL < INDEX_CAPACITY))
+        reinterpret_cast<quint32*>(m_map + INDEX_OFFSET)[m_count/INDEX_INTERVAL] = static_cast<quint32>(ms);
+    storeCount(m_map, ++m_count);
+    return true;
+}
+
+qint64 CaptureWriter::toMs(qint64 tNs)
+{
+    // the first record or mark is written at t = 0
+    if (!m_started) {
+        m_t0Ns = tNs;
+        m_started = true;
+    }
+    return qMax<qint64>(0, (tNs - m_t0Ns)/1000000);
+}
+
+bool CaptureWriter::mark(qint64 tNs)
+{
+    if ((m_map == nullptr) || (m_markCount >= MARK_CAPACITY))
+        return false;
+    const qint64 ms = toMs(tNs);
+    reinterpret_cast<quint32*>(m_map + MARK_OFFSET)[m_markCount] = static_cast<quint32>(qMin<qint64>(ms, CAPTURE_TIME_MASK));
+    storeMarkCount(m_map, ++m_markCount);
+    return true;
+}
+
+
+CaptureReader::CaptureReader()
+    : m_map(nullptr)
+    , m_mapSize(0)
+    , m_count(0)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString &fileName)
+{
+    close();
+    m_error.clear();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::ReadOnly))
+        return false;
+    if (!map()) {
+        close();
+        return false;
+    }
+    const CAPTURE_HEADER &h = header();
+    if ((memcmp(h.magic, CAPTURE_MAGIC, sizeof(h.magic)) != 0) || (h.version != CAPTURE_VERSION)
+            || (h.headerSize != HEADER_SIZE) || (h.recordSize != sizeof(CAPTURE_RECORD))
+            || (h.indexInterval == 0) || (h.indexCapacity > INDEX_CAPACITY)) {
+        close();
+        m_error = QString("%1 is not a capture file").arg(fileName);
+        return false;
+    }
+    refresh();
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if (m_map != nullptr) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapSize = 0;
+    m_count = 0;
+    m_file.close();
+}
+
+bool CaptureReader::map()
+{
+    if (m_map != nullptr)
+        m_file.unmap(m_map);
+    m_mapSize = m_file.size();
+    m_map = (m_mapSize >= HEADER_SIZE) ? m_file.map(0, m_mapSize) : nullptr;
+    if (m_map == nullptr) {
+        m_mapSize = 0;
+        if (m_error.isEmpty() && (m_file.error() == QFile::NoError))
+            m_error = QString("%1 is too short").arg(m_file.fileName());
+        return false;
+    }
+    return true;
+}
+
+quint64 CaptureReader::refresh()
+{
+    if (m_map == nullptr)
+        return 0;
+    const quint64 count = loadCount(m_map);
+    // the writer has grown the file since it was mapped
+    if ((HEADER_SIZE + count*sizeof(CAPTURE_RECORD) > static_cast<quint64>(m_mapSize)) && !map())
+        return m_count = 0;
+    m_count = qMin(count, (static_cast<quint64>(m_mapSize) - HEADER_SIZE)/sizeof(CAPTURE_RECORD));
+    return m_count;
+}
+
+quint64 CaptureReader::lowerBound(quint32 ms) const
+{
+    // narrow the search down to one index interval using the index only, so
+    // that only a few pages of the records are touched
+    const quint64 interval = header().indexInterval;
+    const quint64 entries = qMin<quint64>((m_count + interval - 1)/interval, header().indexCapacity);
+    const quint32 *idx = index(m_map);
+    quint64 lo = 0;
+    quint64 hi = entries;
+    while (lo < hi) {
+        const quint64 mid = lo + (hi - lo)/2;
+        if (idx[mid] < ms)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    quint64 begin = (lo > 0) ? (lo - 1)*interval : 0;
+    quint64 end = (lo < entries) ? lo*interval : m_count;
+    const CAPTURE_RECORD *r = records(m_map);
+    while (begin < end) {
+        const quint64 mid = begin + (end - begin)/2;
+        if (timeMs(r[mid]) < ms)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    return begin;
+}
+
+CaptureFile::RANGE CaptureReader::slice(quint32 fromMs, quint32 toMs) const
+{
+    RANGE r;
+    r.begin = lowerBound(fromMs);
+    r.end = qMax(r.begin, lowerBound(toMs));
+    return r;
+}
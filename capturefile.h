@@ -0,0 +1,160 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// capturefile.h
+// memory mapped binary capture files of measured values, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// File layout (little endian):
+//   0                 CAPTURE_HEADER
+//   INDEX_OFFSET      sparse index, time of every INDEX_INTERVAL-th record
+//   MARK_OFFSET       times of the marks (e.g. triggers)
+//   HEADER_SIZE       CAPTURE_RECORD[count]
+// The file is preallocated in chunks and written through a memory mapping.
+// A record (mark) is published by storing the new count into the header after
+// the record itself, so readers may open the file while it is being written.
+// ***************************************************************************
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QFile>
+#include <QString>
+#include "mp7100protocol.h"
+
+#define CAPTURE_MAGIC       "MP7100CP"
+#define CAPTURE_VERSION     1
+
+// all values in model units, see voltageScale and currentScale
+typedef struct {
+    char        magic[8];       // CAPTURE_MAGIC, not 0 terminated
+    quint32     version;
+    quint32     headerSize;     // offset of the first record
+    quint32     recordSize;
+    quint32     indexInterval;  // records per index entry
+    quint32     indexCapacity;  // maximum number of index entries
+    quint32     voltageScale;   // counts per volt
+    quint32     currentScale;   // counts per ampere
+    quint32     minU, minI;     // device limits from GMIN
+    quint32     maxU, maxI;     // device limits from GMAX
+    quint32     markCount;      // number of valid marks, written last
+    qint64      startMs;        // wall clock time of t = 0 in ms since epoch (UTC)
+    quint64     count;          // number of valid records, written last
+} CAPTURE_HEADER;
+
+// one sample, t is 31 bit (24 days) in ms since startMs
+#define CAPTURE_CC_FLAG     0x80000000u
+#define CAPTURE_TIME_MASK   0x7fffffffu
+typedef struct {
+    quint32     t;              // time in ms | CAPTURE_CC_FLAG in constant current mode
+    quint16     u;
+    quint16     i;
+} CAPTURE_RECORD;
+
+class CaptureFile
+{
+public:
+    enum {
+        HEADER_SIZE = 65536,
+        INDEX_OFFSET = 128,
+        MARK_OFFSET = 57344,
+        INDEX_CAPACITY = (MARK_OFFSET - INDEX_OFFSET)/4,
+        MARK_CAPACITY = (HEADER_SIZE - MARK_OFFSET)/4,
+        INDEX_INTERVAL = 4096,
+        CHUNK_RECORDS = 1 << 20         // file grows by 8 MB
+    };
+
+    // device limits stored in the header
+    typedef struct {
+        double  minU, minI;
+        double  maxU, maxI;
+    } LIMITS;
+
+    // absolute record indices [begin, end)
+    typedef struct {
+        quint64 begin;
+        quint64 end;
+    } RANGE;
+
+protected:
+    static const quint32 *index(const uchar *map) { return reinterpret_cast<const quint32*>(map + INDEX_OFFSET); }
+    static const quint32 *marks(const uchar *map) { return reinterpret_cast<const quint32*>(map + MARK_OFFSET); }
+    static const CAPTURE_RECORD *records(const uchar *map) { return reinterpret_cast<const CAPTURE_RECORD*>(map + HEADER_SIZE); }
+    static quint64 loadCount(const uchar *map);
+    static void storeCount(uchar *map, quint64 count);
+    static quint32 loadMarkCount(const uchar *map);
+    static void storeMarkCount(uchar *map, quint32 count);
+};
+
+class CaptureWriter : public CaptureFile
+{
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    bool open(const QString &fileName, const MP7100Protocol::MODEL &model, const LIMITS &limits);
+    // truncates the file to the records written
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString errorString() const { return m_file.errorString(); }
+
+    // tNs is a monotonic host time, the first record is written at t = 0
+    bool append(qint64 tNs, double u, double i, bool cc);
+    quint64 count() const { return m_count; }
+    // mark the time tNs, e.g. of a trigger
+    bool mark(qint64 tNs);
+
+private:
+    bool grow();
+    qint64 toMs(qint64 tNs);
+
+    QFile       m_file;
+    uchar       *m_map;
+    quint64     m_capacity;     // records fitting into the mapped file
+    quint64     m_count;
+    quint32     m_markCount;
+    bool        m_started;      // m_t0Ns is valid
+    qint64      m_t0Ns;
+    quint32     m_voltageScale, m_currentScale;
+};
+
+class CaptureReader : public CaptureFile
+{
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString errorString() const { return m_error.isEmpty() ? m_file.errorString() : m_error; }
+
+    const CAPTURE_HEADER &header() const { return *reinterpret_cast<const CAPTURE_HEADER*>(m_map); }
+    // number of records published so far, remaps the file if the writer has grown it
+    quint64 refresh();
+    quint64 count() const { return m_count; }
+    // records [0, count()), valid until the next refresh()
+    const CAPTURE_RECORD &record(quint64 n) const { return records(m_map)[n]; }
+    static quint32 timeMs(const CAPTURE_RECORD &r) { return r.t & CAPTURE_TIME_MASK; }
+    // records with fromMs <= t < toMs
+    RANGE slice(quint32 fromMs, quint32 toMs) const;
+    // marks published so far, in ms
+    int markCount() const { return m_map ? static_cast<int>(qMin<quint32>(loadMarkCount(m_map), MARK_CAPACITY)) : 0; }
+    quint32 markMs(int n) const { return marks(m_map)[n]; }
+
+private:
+    bool map();
+    quint64 lowerBound(quint32 ms) const;
+
+    QFile       m_file;
+    uchar       *m_map;
+    qint64      m_mapSize;
+    quint64     m_count;
+    QString     m_error;
+};
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,80 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// emulator/main.cpp
+// MP7100 device emulator, application entry point
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "mp7100emulator.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <csignal>
+#include <cstdio>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int signalFd[2];
+
+static void onSignal(int)
+{
+    char c = 1;
+    if (::write(signalFd[0], &c, 1) != 1) {
+        // nothing sensible to do in a signal handler
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("mp7100emu");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Emulates a Multicomp MP7100 power supply on a pseudo terminal.");
+    parser.addHelpOption();
+    QCommandLineOption linkOption("link", "Create a symbolic link <path> to the pseudo terminal.", "path");
+    QCommandLineOption latencyOption("latency", "Processing time of every command in microseconds.", "us", "2000");
+    QCommandLineOption jitterOption("jitter", "Additional random latency up to <us> microseconds.", "us", "0");
+    QCommandLineOption baudOption("baud", "Emulated line speed, 0 disables pacing.", "baud", "9600");
+    QCommandLineOption dropOption("drop", "Probability of a lost reply (0..1).", "p", "0");
+    QCommandLineOption corruptOption("corrupt", "Probability of a corrupted reply (0..1).", "p", "0");
+    QCommandLineOption loadOption("load", "Resistance of the emulated load in ohms, 0 is open circuit.", "ohms", "10");
+    parser.addOption(linkOption);
+    parser.addOption(latencyOption);
+    parser.addOption(jitterOption);
+    parser.addOption(baudOption);
+    parser.addOption(dropOption);
+    parser.addOption(corruptOption);
+    parser.addOption(loadOption);
+    parser.process(a);
+
+    MP7100Emulator::CONFIG config;
+    config.latencyUs = parser.value(latencyOption).toInt();
+    config.jitterUs = parser.value(jitterOption).toInt();
+    config.baudrate = parser.value(baudOption).toInt();
+    config.dropRate = parser.value(dropOption).toDouble();
+    config.corruptRate = parser.value(corruptOption).toDouble();
+    config.loadOhms = parser.value(loadOption).toDouble();
+    config.maxU = 3000;
+    config.maxI = 5000;
+
+    MP7100Emulator emu(config);
+    if (!emu.open(parser.value(linkOption)))
+        return 1;
+    printf("%s\n", qPrintable(emu.portName()));
+    fflush(stdout);
+
+    // quit cleanly on SIGINT / SIGTERM, so the link gets removed
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFd) == 0) {
+        QSocketNotifier *sn = new QSocketNotifier(signalFd[1], QSocketNotifier::Read, &a);
+        QObject::connect(sn, SIGNAL(activated(int)), &a, SLOT(quit()));
+        signal(SIGINT, onSignal);
+        signal(SIGTERM, onSignal);
+    }
+    return a.exec();
+}
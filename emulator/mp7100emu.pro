@@ -0,0 +1,18 @@
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+!unix: error("the MP7100 emulator uses pseudo terminals and needs Linux")
+
+TARGET = mp7100emu
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    mp7100emulator.cpp
+
+HEADERS += \
+    mp7100emulator.h \
+    ../mp7100protocol.h
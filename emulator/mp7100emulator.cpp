@@ -0,0 +1,236 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// mp7100emulator.cpp
+// MP7100 device emulator on a pseudo terminal
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "mp7100emulator.h"
+#include <QSocketNotifier>
+#include <QRandomGenerator>
+#include <QFile>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+MP7100Emulator::MP7100Emulator(const CONFIG &config, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+    , m_master(-1)
+    , m_slave(-1)
+    , m_notifier(nullptr)
+    , m_rxFreeNs(0)
+    , m_txFreeNs(0)
+    , m_on(false)
+    , m_setU(0)
+    , m_setI(0)
+    , m_commands(0)
+    , m_dropped(0)
+    , m_corrupted(0)
+{
+    m_clock.start();
+    m_txTimer.setSingleShot(true);
+    m_txTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_txTimer, &QTimer::timeout, this, &MP7100Emulator::onTxTimer);
+}
+
+MP7100Emulator::~MP7100Emulator()
+{
+    qInfo() << "commands:" << m_commands << "dropped replies:" << m_dropped << "corrupted replies:" << m_corrupted;
+    delete m_notifier;
+    if (!m_linkName.isEmpty())
+        QFile::remove(m_linkName);
+    if (m_slave >= 0)
+        ::close(m_slave);
+    if (m_master >= 0)
+        ::close(m_master);
+}
+
+bool MP7100Emulator::open(const QString &linkName)
+{
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((m_master < 0) || (grantpt(m_master) != 0) || (unlockpt(m_master) != 0)) {
+        qCritical() << "cannot create pseudo terminal:" << strerror(errno);
+        return false;
+    }
+    m_portName = QString::fromLocal8Bit(ptsname(m_master));
+    // keep the slave open, so the master doesn't see a hangup whenever the
+    // client closes the port, and switch it to raw mode
+    m_slave = ::open(ptsname(m_master), O_RDWR | O_NOCTTY);
+    if (m_slave < 0) {
+        qCritical() << "cannot open" << m_portName << ":" << strerror(errno);
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(m_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(m_slave, TCSANOW, &tio);
+    fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+
+    if (!linkName.isEmpty()) {
+        QFile::remove(linkName);
+        if (QFile::link(m_portName, linkName)) {
+            m_linkName = linkName;
+        } else {
+            qWarning() << "cannot create link" << linkName;
+        }
+    }
+    m_notifier = new QSocketNotifier(m_master, QSocketNotifier::Read, this);
+    // activated() is overloaded since Qt 5.15, use the string based connect
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(onReadable()));
+    return true;
+}
+
+qint64 MP7100Emulator::byteNs() const
+{
+    // start bit, 8 data bits, stop bit
+    return m_config.baudrate > 0 ? 10*1000000000LL/m_config.baudrate : 0;
+}
+
+void MP7100Emulator::onReadable()
+{
+    char buffer[256];
+    ssize_t n;
+    while ((n = ::read(m_master, buffer, sizeof(buffer))) > 0) {
+        const qint64 now = m_clock.nsecsElapsed();
+        for (ssize_t k = 0; k < n; ++k) {
+            // every byte needs its transmission time on the emulated line
+            m_rxFreeNs = qMax(m_rxFreeNs, now) + byteNs();
+            if (buffer[k] == '\r') {
+                handleLine(m_rxLine, m_rxFreeNs);
+                m_rxLine.clear();
+            } else if (m_rxLine.size() < 64) {
+                m_rxLine.append(buffer[k]);
+            }
+        }
+    }
+}
+
+void MP7100Emulator::output(quint32 &u, quint32 &i, bool &cc) const
+{
+    // constant voltage until the load draws more than the set current
+    u = 0;
+    i = 0;
+    cc = false;
+    if (!m_on || (m_config.loadOhms <= 0.))
+        return;
+    const double volts = m_setU/100.;
+    const double amps = volts/m_config.loadOhms;
+    if (amps*1000. > m_setI) {
+        cc = true;
+        i = m_setI;
+        u = static_cast<quint32>(m_setI/1000.*m_config.loadOhms*100. + 0.5);
+    } else {
+        u = m_setU;
+        i = static_cast<quint32>(amps*1000. + 0.5);
+    }
+}
+
+void MP7100Emulator::handleLine(const QByteArray &line, qint64 rxDoneNs)
+{
+    MP7100Protocol::COMMAND_ID id = MP7100Protocol::identify(line.constData(), line.size());
+    if (id == MP7100Protocol::CommandCount) {
+        qWarning() << "unknown command" << line;
+        return;
+    }
+    m_commands++;
+    const MP7100Protocol::COMMAND_DESC &desc = MP7100Protocol::commands[id];
+    const int mnemonicSize = static_cast<int>(strlen(desc.mnemonic));
+    if (line.size() != mnemonicSize + desc.args*desc.digits) {
+        qWarning() << "invalid arguments" << line;
+        return;
+    }
+    quint32 args[2] = { 0, 0 };
+    for (int a = 0; (a < desc.args) && (a < 2); ++a) {
+        args[a] = line.mid(mnemonicSize + a*desc.digits, desc.digits).toUInt();
+    }
+
+    quint32 u, i;
+    bool cc;
+    QByteArray data;
+    switch (id) {
+    case MP7100Protocol::CmdSetOnOff:
+        m_on = args[0] != 0;
+        break;
+    case MP7100Protocol::CmdGetOnOff:
+        data = m_on ? "1" : "0";
+        break;
+    case MP7100Protocol::CmdSetVoltageCurrent:
+        m_setU = qMin(args[0], m_config.maxU);
+        m_setI = qMin(args[1], m_config.maxI);
+        break;
+    case MP7100Protocol::CmdGetDisplayVoltageCurrent:
+        output(u, i, cc);
+        data = QString("%1;%2;%3").arg(u, 4, 10, QLatin1Char('0')).arg(i, 4, 10, QLatin1Char('0')).arg(cc ? 1 : 0).toLatin1();
+        break;
+    case MP7100Protocol::CmdGetSetVoltageCurrent:
+        data = QString("%1;%2").arg(m_setU, 4, 10, QLatin1Char('0')).arg(m_setI, 4, 10, QLatin1Char('0')).toLatin1();
+        break;
+    case MP7100Protocol::CmdGetMinimumVoltageCurrent:
+        data = "0000;0000";
+        break;
+    case MP7100Protocol::CmdGetMaximumVoltageCurrent:
+        data = QString("%1;%2").arg(m_config.maxU, 4, 10, QLatin1Char('0')).arg(m_config.maxI, 4, 10, QLatin1Char('0')).toLatin1();
+        break;
+    default:
+        break;
+    }
+    if (!data.isEmpty())
+        data.append('\r');
+    data.append("OK\r");
+
+    qint64 latencyNs = m_config.latencyUs*1000LL;
+    if (m_config.jitterUs > 0)
+        latencyNs += QRandomGenerator::global()->bounded(m_config.jitterUs)*1000LL;
+    reply(data, rxDoneNs + latencyNs);
+}
+
+void MP7100Emulator::reply(QByteArray data, qint64 readyNs)
+{
+    QRandomGenerator *rnd = QRandomGenerator::global();
+    if ((m_config.dropRate > 0.) && (rnd->generateDouble() < m_config.dropRate)) {
+        m_dropped++;
+        return;
+    }
+    if ((m_config.corruptRate > 0.) && (rnd->generateDouble() < m_config.corruptRate)) {
+        // garble one character, but keep the line structure intact
+        int pos = rnd->bounded(data.size());
+        if (data[pos] != '\r')
+            data[pos] = '?';
+        m_corrupted++;
+    }
+    PENDING p;
+    p.data = data;
+    m_txFreeNs = qMax(m_txFreeNs, readyNs) + data.size()*byteNs();
+    p.dueNs = m_txFreeNs;
+    m_tx.enqueue(p);
+    scheduleTx();
+}
+
+void MP7100Emulator::scheduleTx()
+{
+    if (m_tx.isEmpty() || m_txTimer.isActive())
+        return;
+    const qint64 waitNs = m_tx.head().dueNs - m_clock.nsecsElapsed();
+    m_txTimer.start(waitNs > 0 ? static_cast<int>((waitNs + 999999)/1000000) : 0);
+}
+
+void MP7100Emulator::onTxTimer()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    while (!m_tx.isEmpty() && (m_tx.head().dueNs <= now)) {
+        PENDING p = m_tx.dequeue();
+        if (::write(m_master, p.data.constData(), static_cast<size_t>(p.data.size())) != p.data.size())
+            qWarning() << "write error:" << strerror(errno);
+    }
+    scheduleTx();
+}
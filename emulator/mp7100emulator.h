@@ -0,0 +1,79 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// mp7100emulator.h
+// MP7100 device emulator on a pseudo terminal, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef MP7100EMULATOR_H
+#define MP7100EMULATOR_H
+
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "mp7100protocol.h"
+
+class QSocketNotifier;
+
+class MP7100Emulator : public QObject
+{
+    Q_OBJECT
+public:
+    typedef struct {
+        int     latencyUs;      // processing time of every command
+        int     jitterUs;       // uniformly distributed additional latency
+        int     baudrate;       // emulated line speed, 0 disables pacing
+        double  dropRate;       // probability that a reply gets lost
+        double  corruptRate;    // probability that a reply gets corrupted
+        double  loadOhms;       // resistance of the emulated load
+        quint32 maxU;           // maximum voltage in 10 mV
+        quint32 maxI;           // maximum current in 1 mA
+    } CONFIG;
+
+    explicit MP7100Emulator(const CONFIG &config, QObject *parent = nullptr);
+    ~MP7100Emulator();
+
+    // create the pseudo terminal, optionally with a symbolic link to it
+    bool open(const QString &linkName = QString());
+    QString portName() const { return m_portName; }
+
+private slots:
+    void onReadable();
+    void onTxTimer();
+
+private:
+    typedef struct {
+        QByteArray  data;
+        qint64      dueNs;      // time the last byte has been transmitted
+    } PENDING;
+
+    void handleLine(const QByteArray &line, qint64 rxDoneNs);
+    void reply(QByteArray data, qint64 readyNs);
+    void scheduleTx();
+    void output(quint32 &u, quint32 &i, bool &cc) const;
+    qint64 byteNs() const;
+
+    CONFIG          m_config;
+    int             m_master;
+    int             m_slave;
+    QString         m_portName;
+    QString         m_linkName;
+    QSocketNotifier *m_notifier;
+    QElapsedTimer   m_clock;
+    QByteArray      m_rxLine;
+    qint64          m_rxFreeNs;     // time the emulated receive line is idle again
+    qint64          m_txFreeNs;     // time the emulated transmit line is idle again
+    QQueue<PENDING> m_tx;
+    QTimer          m_txTimer;
+    bool            m_on;
+    quint32         m_setU, m_setI;
+    quint64         m_commands, m_dropped, m_corrupted;
+};
+
+#endif // MP7100EMULATOR_H
@@ -0,0 +1,55 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// energymeter.cpp
+// charge and energy integration per output on session
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "energymeter.h"
+
+EnergyMeter::EnergyMeter()
+    : m_hasLast(false)
+    , m_lastNs(0)
+    , m_lastU(0.)
+    , m_lastI(0.)
+{
+    m_session.start = QDateTime::currentDateTime();
+    m_session.durationNs = 0;
+    m_session.ah = 0.;
+    m_session.wh = 0.;
+}
+
+void EnergyMeter::startSession()
+{
+    if (m_session.durationNs > 0) {
+        m_history.append(m_session);
+        while (m_history.size() > MAX_HISTORY)
+            m_history.removeFirst();
+    }
+    m_session.start = QDateTime::currentDateTime();
+    m_session.durationNs = 0;
+    m_session.ah = 0.;
+    m_session.wh = 0.;
+    // the next sample starts the integration
+    m_hasLast = false;
+}
+
+void EnergyMeter::add(qint64 tNs, double u, double i)
+{
+    const qint64 dt = tNs - m_lastNs;
+    if (m_hasLast && (dt > 0) && (dt <= static_cast<qint64>(MAX_GAP_MS)*1000000)) {
+        const double hours = dt/3.6e12;
+        m_session.ah += 0.5*(m_lastI + i)*hours;
+        m_session.wh += 0.5*(m_lastU*m_lastI + u*i)*hours;
+        m_session.durationNs += dt;
+    }
+    m_hasLast = true;
+    m_lastNs = tNs;
+    m_lastU = u;
+    m_lastI = i;
+}
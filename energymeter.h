@@ -0,0 +1,55 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// energymeter.h
+// charge and energy integration per output on session, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Voltage and current are integrated with the trapezoidal rule over the host
+// timestamps of the samples, O(1) per sample. Intervals longer than
+// MAX_GAP_MS (e.g. while the device is reconnected) are not integrated.
+// ***************************************************************************
+#ifndef ENERGYMETER_H
+#define ENERGYMETER_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QDateTime>
+
+class EnergyMeter
+{
+public:
+    enum { MAX_GAP_MS = 5000, MAX_HISTORY = 16 };
+
+    typedef struct {
+        QDateTime   start;
+        qint64      durationNs;     // integrated time
+        double      ah;
+        double      wh;
+    } SESSION;
+
+    EnergyMeter();
+
+    // finish the current session and start a new one
+    void startSession();
+    // tNs is a monotonic host time
+    void add(qint64 tNs, double u, double i);
+
+    const SESSION &session() const { return m_session; }
+    // finished sessions, newest last
+    const QList<SESSION> &history() const { return m_history; }
+
+private:
+    SESSION         m_session;
+    QList<SESSION>  m_history;
+    bool            m_hasLast;
+    qint64          m_lastNs;
+    double          m_lastU, m_lastI;
+};
+
+#endif // ENERGYMETER_H
@@ -0,0 +1,49 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// logcategories.cpp
+// logging categories of the subsystems
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "logcategories.h"
+
+#define CATEGORY_PREFIX     "mp7100."
+
+Q_LOGGING_CATEGORY(lcSerial, CATEGORY_PREFIX "serial", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcProtocol, CATEGORY_PREFIX "protocol", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcGui, CATEGORY_PREFIX "gui", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcPower, CATEGORY_PREFIX "power", QtInfoMsg)
+
+QStringList LogCategories::m_debug;
+
+QStringList LogCategories::names()
+{
+    return QStringList() << "serial" << "protocol" << "gui" << "power";
+}
+
+void LogCategories::setDebug(const QStringList &names)
+{
+    const QStringList all = LogCategories::names();
+    m_debug.clear();
+    for (const QString &name : names) {
+        const QString n = name.trimmed().toLower();
+        if (n == "all")
+            m_debug = all;
+        else if (all.contains(n) && !m_debug.contains(n))
+            m_debug.append(n);
+    }
+    // the rules are evaluated once here, not per message
+    QString rules = CATEGORY_PREFIX "*.debug=false\n";
+#ifndef QT_DEBUG
+    // plain qDebug() is for development builds only
+    rules += "default.debug=false\n";
+#endif
+    for (const QString &n : m_debug)
+        rules += QString(CATEGORY_PREFIX "%1.debug=true\n").arg(n);
+    QLoggingCategory::setFilterRules(rules);
+}
@@ -0,0 +1,43 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// logcategories.h
+// logging categories of the subsystems, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// qCDebug(lcSerial) and TCLOG_DEBUG(lcSerial, ...) test the category before
+// any argument is evaluated, a disabled message costs one flag test. Debug
+// messages are off unless their category is enabled by --log or in the UI,
+// warnings and errors are always on.
+// ***************************************************************************
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+#include <QStringList>
+
+Q_DECLARE_LOGGING_CATEGORY(lcSerial)      // serial port
+Q_DECLARE_LOGGING_CATEGORY(lcProtocol)    // commands and replies
+Q_DECLARE_LOGGING_CATEGORY(lcGui)         // user interface
+Q_DECLARE_LOGGING_CATEGORY(lcPower)       // power management events
+
+class LogCategories
+{
+public:
+    // "serial", "protocol", "gui", "power"
+    static QStringList names();
+    // enables the debug messages of the named categories only, "all"
+    // selects all of them, unknown names are ignored
+    static void setDebug(const QStringList &names);
+    static QStringList debug() { return m_debug; }
+
+private:
+    static QStringList m_debug;
+};
+
+#endif // LOGCATEGORIES_H
@@ -12,11 +12,27 @@
 // ***************************************************************************
 #include "mainwidget.h"
 #include "tapp.h"
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     TApp a(argc, argv);
-    MainWidget w;
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::translate("main", "Control tool for Multicomp MP7100 power supplies"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption portOption(QStringList() << "p" << "port",
+                                  QCoreApplication::translate("main", "Serial port of the power supply, e.g. COM12 or /dev/pts/3."),
+                                  QCoreApplication::translate("main", "port"));
+    parser.addOption(portOption);
+    QCommandLineOption logOption(QStringList() << "l" << "log",
+                                 QCoreApplication::translate("main", "Debug messages of the comma separated categories serial, protocol, gui, power or all."),
+                                 QCoreApplication::translate("main", "categories"));
+    parser.addOption(logOption);
+    parser.process(a);
+
+    // without --log the categories stored in the settings are used
+    MainWidget w(parser.value(portOption), parser.isSet(logOption) ? parser.value(logOption) : QString());
     w.show();
     return a.exec();
 }
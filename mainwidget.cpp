@@ -16,29 +16,61 @@
 #include "tapp.h"
 #include "tmessagehandler.h"
 #include "silentcall.h"
+#include "tlog.h"
+#include "logcategories.h"
 #include <QDebug>
 #include <QTimer>
 #include <QSettings>
 #include <QTimerEvent>
 #include <QMessageBox>
 #include <QSettings>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QScrollBar>
 #include "mp7100.h"
+#include "tracecodec.h"
 
 #define GRP_MP7100          "MP7100_Config"
 #define CFG_ALWAYS_ON_TOP   "alwaysOnTop"
 #define CFG_LOG_FONT_SIZE   "logFont"
+#define CFG_PORT            "port"
+#define CFG_FAST_ACQUISITION "fastAcquisition"
+#define CFG_PROTECT         "protect"
+#define CFG_PROTECT_AMPS    "protectAmps"
+#define CFG_PROTECT_WATTS   "protectWatts"
+#define CFG_SEQUENCE_FILE   "sequenceFile"
+#define CFG_LOG_CATEGORIES  "logCategories"
+// regulation parameters, not shown in the UI
+#define CFG_REGULATION_KP   "regulationKp"
+#define CFG_REGULATION_KI   "regulationKi"
+#define CFG_REGULATION_RATE "regulationRate"
+#define DEFAULT_REGULATION_KP   0.3
+#define DEFAULT_REGULATION_KI   5.0
+#define DEFAULT_REGULATION_RATE 10.0
+#define DEFAULT_PORT        "COM12"
 
 
 // expect a successful new measurement at least every second
 #define UPDATE_MS   300
 #define WATCHDOG_MS 2000
-
-MainWidget::MainWidget(QWidget *parent)
+// on/off state and set values are read less often in fast acquisition mode
+#define SLOW_POLL_MS 1000
+// history saved before and after a trigger
+#define SNAPSHOT_PRE_MS     2000
+#define SNAPSHOT_POST_MS    2000
+#define TRIGGER_ID          1
+
+MainWidget::MainWidget(const QString &portName, const QString &logCategories, QWidget *parent)
     : TMainWidget(parent)
     , ui(new Ui::MainWidget)
-    , m_lastCommandErrorRequest(false)
+    , m_logFollow(true)
+    , m_portName(portName)
     , m_dev(nullptr)
     , m_state(Uninitialized)
+    , m_pendingQueries(0)
     , m_idUpdateTimer(0)
     , m_idWatchdogTimer(0)
     , m_setOnOff(false)
@@ -47,19 +79,49 @@ MainWidget::MainWidget(QWidget *parent)
     , m_setCurrentChanged(false)
     , m_indicatorCount(0)
     , m_indicatorInc(8)
+    , m_devTimeOffsetNs(0)
+    , m_limits{0., 0., 0., 0.}
+    , m_stats{ WindowStats(1000), WindowStats(60000), WindowStats(3600000) }
 {
     ui->setupUi(this);
+    m_clock.start();
     QSettings cfg;
     cfg.beginGroup(GRP_MP7100);
     ui->alwaysOnTop->setChecked(cfg.value(CFG_ALWAYS_ON_TOP, false).toBool());
     setWindowFlag(Qt::WindowStaysOnTopHint, ui->alwaysOnTop->isChecked());
-    QFont f = ui->textMessage->document()->defaultFont();
+    SilentCall(ui->fastAcquisition)->setChecked(cfg.value(CFG_FAST_ACQUISITION, false).toBool());
+    SilentCall(ui->protect)->setChecked(cfg.value(CFG_PROTECT, false).toBool());
+    ui->protectAmps->setValue(cfg.value(CFG_PROTECT_AMPS, 0.).toDouble());
+    ui->protectWatts->setValue(cfg.value(CFG_PROTECT_WATTS, 0.).toDouble());
+    QFont f = ui->textMessage->font();
     f.setPointSizeF(cfg.value(CFG_LOG_FONT_SIZE, f.pointSizeF()).toReal());
-    ui->textMessage->document()->setDefaultFont(f);
+    ui->textMessage->setFont(f);
+    if (m_portName.isEmpty())
+        m_portName = cfg.value(CFG_PORT, DEFAULT_PORT).toString();
+    // a port given on the command line becomes the new default
+    cfg.setValue(CFG_PORT, m_portName);
+    // debug categories as well
+    if (logCategories.isNull())
+        LogCategories::setDebug(cfg.value(CFG_LOG_CATEGORIES).toStringList());
+    else
+        LogCategories::setDebug(logCategories.split(','));
+    cfg.setValue(CFG_LOG_CATEGORIES, LogCategories::debug());
+    const QStringList debug = LogCategories::debug();
+    SilentCall(ui->logSerial)->setChecked(debug.contains("serial"));
+    SilentCall(ui->logProtocol)->setChecked(debug.contains("protocol"));
+    SilentCall(ui->logGui)->setChecked(debug.contains("gui"));
+    SilentCall(ui->logPower)->setChecked(debug.contains("power"));
+    m_log.setShowDebug(!debug.isEmpty());
     cfg.endGroup();
+    qInfo() << "using serial port" << m_portName;
 
-    // allow debug message display
-    connect(reinterpret_cast<TApp*>(qApp)->msgHandler(), SIGNAL(messageAdded(QString)), this, SLOT(on_messageAdded(QString)));
+    // allow debug message display, only the visible lines are formatted
+    ui->textMessage->setModel(&m_log);
+    ui->textMessage->setUniformItemSizes(true);
+    connect(reinterpret_cast<TApp*>(qApp)->msgHandler(), &TMessageHandler::messagesAdded, &m_log, &TLogModel::append);
+    connect(reinterpret_cast<TApp*>(qApp)->msgHandler(), &TMessageHandler::messageSaved, this, []() { qInfo() << "log saved"; });
+    connect(&m_log, &TLogModel::rowsAboutToBeInserted, this, &MainWidget::onLogRowsAboutToBeInserted);
+    connect(&m_log, &TLogModel::rowsInserted, this, &MainWidget::onLogRowsInserted);
 
     // handle power events
     connect(this, &MainWidget::ResumeSuspend, this, &MainWidget::onResume);
@@ -79,6 +141,30 @@ MainWidget::MainWidget(QWidget *parent)
     ui->setVolts->setStyleSheet("color:black;");
     ui->setAmps->setStyleSheet("color:black;");
     ui->CC_CV->setFont(fontLCDsmall);
+    ui->trend->setStore(&m_store);
+    ui->statsWindow->addItems(QStringList() << tr("1 s") << tr("1 min") << tr("1 h"));
+    ui->statsWindow->setStyleSheet("color:white;");
+    connect(ui->statsWindow, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWidget::updateStatistics);
+    connect(ui->protectAmps, &QDoubleSpinBox::editingFinished, this, &MainWidget::updateProtection);
+    connect(ui->logSerial, &QCheckBox::toggled, this, &MainWidget::updateLogCategories);
+    connect(ui->logProtocol, &QCheckBox::toggled, this, &MainWidget::updateLogCategories);
+    connect(ui->logGui, &QCheckBox::toggled, this, &MainWidget::updateLogCategories);
+    connect(ui->logPower, &QCheckBox::toggled, this, &MainWidget::updateLogCategories);
+    // same order as Regulator::MODE
+    ui->regulationMode->addItems(QStringList() << tr("CV / CC") << tr("Constant power") << tr("Constant resistance"));
+    ui->regulationValue->setEnabled(false);
+    connect(ui->regulationValue, &QDoubleSpinBox::editingFinished, this, &MainWidget::applyRegulation);
+    connect(ui->protectWatts, &QDoubleSpinBox::editingFinished, this, &MainWidget::updateProtection);
+    // same order as TriggerEngine::CONDITION
+    ui->triggerCondition->addItems(QStringList() << tr("I >") << tr("I <") << tr("U >") << tr("U <") << tr("CV -> CC") << tr("CC -> CV"));
+    ui->triggerAction->addItem(tr("Output off"), TriggerEngine::ActionOutputOff);
+    ui->triggerAction->addItem(tr("Mark"), TriggerEngine::ActionMark);
+    ui->triggerAction->addItem(tr("Snapshot"), TriggerEngine::ActionSnapshot);
+    ui->triggerAction->addItem(tr("Off + snapshot"), TriggerEngine::ActionOutputOff | TriggerEngine::ActionSnapshot);
+
+    // all serial communication is done in a separate thread
+    m_ioThread.setObjectName("MP7100 I/O");
+    m_ioThread.start(QThread::HighestPriority);
     reconnectDevice();
 }
 
@@ -98,14 +184,17 @@ void MainWidget::startDevice()
 
 MainWidget::~MainWidget()
 {
-    qDebug() << "MainWidget::~MainWidget()";
+    qCDebug(lcGui) << "MainWidget::~MainWidget()";
     // save log window font size to restore zoom level on next start
     QSettings cfg;
     cfg.beginGroup(GRP_MP7100);
-    qreal s = ui->textMessage->document()->defaultFont().pointSizeF();
+    qreal s = ui->textMessage->font().pointSizeF();
     cfg.setValue(CFG_LOG_FONT_SIZE, s);
     cfg.endGroup();
-    delete m_dev;
+    disconnectDevice();
+    // pending deferred deletes are processed when the thread finishes
+    m_ioThread.quit();
+    m_ioThread.wait();
     delete ui;
 }
 
@@ -114,45 +203,37 @@ void MainWidget::timerEvent(QTimerEvent *event)
     if (event->timerId() == m_idUpdateTimer) {
 //        qDebug() << "+++ MainWidget::timerEvent() +++";
 //        qDebug() << "      flags =" << Qt::hex << m_flags;
-        if (m_setOnOff) {
-            qDebug() << "      -> set on/off to" << (m_newOnOff ? "ON" : "OFF");
-            m_setOnOff = !m_dev->setOnOff(m_newOnOff);
-        } else if (m_setVA) {
-            qDebug() << "      -> set voltage to" << m_newVoltage << "V, current to" << m_newCurrent << "A";
-            m_setVA = !m_dev->setVoltageCurrent(m_newVoltage, m_newCurrent);
-            if (!m_setVA) {
-                m_setVoltageChanged = false;
-                m_setCurrentChanged = false;
-                ui->setVolts->setStyleSheet("color:black;");
-                ui->setAmps->setStyleSheet("color:black;");
-            }
-        } else {
-            switch (m_state) {
-            case Uninitialized:
-                m_state = MinimumVoltageCurrentWaiting;
-                m_dev->getMinimumVoltageCurrent();
-                break;
-            case MinimumVoltageCurrentReceived:
-                m_state = MaximumVoltageCurrentWaiting;
-                m_dev->getMaximumVoltageCurrent();
-                break;
-            case MaximumVoltageCurrentReceived:
-            case SetVoltageCurrentReceived:
-                m_state = GetOnOffWaiting;
-                m_dev->getOnOff();
-                break;
-            case GetOnOffReceived:
-                m_state = DisplayVoltageCurrentWaiting;
-                m_dev->getDisplayVoltageCurrent();
-                break;
-            case DisplayVoltageCurrentReceived:
-                m_state = SetVoltageCurrentWaiting;
-                m_dev->getSetVoltageCurrent();
-                break;
-            default:
-                break;
+        // retry user requests that could not be queued right away
+        sendUserCommands();
+        if (ui->regulationMode->currentIndex() != Regulator::Off)
+            updateRegulationStats();
+        // read the device limits once, the device polls by itself afterwards
+        switch (m_state) {
+        case Uninitialized:
+            m_state = LimitsWaiting;
+            m_dev->getMinimumVoltageCurrent();
+            m_dev->getMaximumVoltageCurrent();
+            m_pendingQueries = 2;
+            break;
+        case LimitsWaiting:
+            if (m_pendingQueries == 0) {
+                m_state = Polling;
+                startPolling();
             }
+            break;
+        case Polling:
+            break;
         }
+        // show the link health of the measurement command
+        MP7100::RTT_STATS rtt = m_dev->rttStats(MP7100Protocol::CmdGetDisplayVoltageCurrent);
+        ui->indicator->setToolTip(tr("GETD round trip: %1 ms (smoothed %2 ms, variation %3 ms)\n"
+                                     "timeout: %4 ms, retries: %5, timeouts: %6")
+                                      .arg(rtt.lastMs, 0, 'f', 1)
+                                      .arg(rtt.srttMs, 0, 'f', 1)
+                                      .arg(rtt.rttvarMs, 0, 'f', 1)
+                                      .arg(rtt.timeoutMs, 0, 'f', 0)
+                                      .arg(rtt.retries)
+                                      .arg(rtt.timeouts));
 //        qDebug() << "--- MainWidget::timerEvent() ---";
     } else if (event->timerId() == m_idWatchdogTimer) {
         if (m_state!=Uninitialized) {
@@ -163,79 +244,76 @@ void MainWidget::timerEvent(QTimerEvent *event)
     }
 }
 
-void MainWidget::on_messageAdded(const QString &msg)
+void MainWidget::sendUserCommands()
 {
-    QTextCursor cursor = ui->textMessage->cursorForPosition(QPoint(0,1));
-    QStringList sl = msg.split(']');
-    QString lineTag = sl.takeFirst() + "]";
-    QString lineText;
-    while (!sl.isEmpty())
-        lineText += sl.takeFirst();
-    bool bold =  lineText.contains("send:");
-    bool italics = lineText.contains("GUI:", Qt::CaseInsensitive);
-    QString lineColor, tagColor;
-
-    // format qDebug() generated lines
-    if (lineText.contains("DBUG")) {
-        // do not add debug lines
+    // user commands are sent as soon as the device runs, they overtake the
+    // queued polling commands
+    if (m_idUpdateTimer == 0)
         return;
-    } else if (lineText.contains("INFO")) {
-    // format qInfo() generated lines
-        tagColor = bold ? "black" : "grey";
-        lineColor = "black";
-        if (lineText.contains("\'BE\'")) {
-            if (bold) {
-                m_lastCommandErrorRequest = true;
-            } else {
-                if (!m_lastCommandErrorRequest) {
-                    tagColor = "chocolate";
-                    lineColor = "chocolate";
-                }
-                m_lastCommandErrorRequest = false;
-            }
-        } else if (lineText.contains("MCP connected", Qt::CaseInsensitive)) {
-            tagColor = "darkgreen";
-            lineColor = "green";
-        } else if (lineText.contains("MCP disconnected", Qt::CaseInsensitive)) {
-            tagColor = "maroon";
-            lineColor = "brown";
+    if (m_setOnOff) {
+        TCLOG_DEBUG(lcGui, "      -> set on/off to %1", m_newOnOff ? "ON" : "OFF");
+        m_setOnOff = !m_dev->setOnOff(m_newOnOff);
+    }
+    if (m_setVA) {
+        TCLOG_DEBUG(lcGui, "      -> set voltage to %1 V, current to %2 A", m_newVoltage, m_newCurrent);
+        m_setVA = !m_dev->setVoltageCurrent(m_newVoltage, m_newCurrent);
+        if (!m_setVA) {
+            m_setVoltageChanged = false;
+            m_setCurrentChanged = false;
+            ui->setVolts->setStyleSheet("color:black;");
+            ui->setAmps->setStyleSheet("color:black;");
         }
-    } else if (lineText.contains("WARN")) {
-    // format qWarning() generated lines
-        tagColor = bold ? "mediumblue" : "royalblue";
-        lineColor = "mediumblue";
-        m_lastCommandErrorRequest = false;
-    } else if (lineText.contains("CRIT")) {
-    // format qCritical() generated lines
-        tagColor = bold ? "firebrick" : "indianred";
-        lineColor = "firebrick";
-        m_lastCommandErrorRequest = false;
-    } else if (lineText.contains("FATL")) {
-    // format qFatal() generated lines
-        tagColor = bold ? "darkviolet" : "blueviolet";
-        lineColor = "darkviolet";
-        m_lastCommandErrorRequest = false;
-    } else {
-    // format all other lines
-        tagColor = bold ? "gray" : "darkgray";
-        lineColor = "gray";
-        m_lastCommandErrorRequest = false;
     }
-    // generate HTML code for this line
-    QString line = "<div><span style=\"color:" + tagColor + ";\">" + lineTag + "</span>" \
-            "<span style=\"color:" + lineColor + ";font-weight:" + QString(bold ? "bold" : "regular") + ";\">" +
-            QString(italics ? "<i>" : "") + lineText.toHtmlEscaped() + QString(italics ? "</i>" : "") + "</span></div>";
-    ui->textMessage->appendHtml(line);
-    // ensure last line is visible
-    cursor.movePosition(QTextCursor::End);
-    cursor.movePosition(QTextCursor::StartOfLine);
-    ui->textMessage->setTextCursor(cursor);
-    ui->textMessage->ensureCursorVisible();
+}
+
+void MainWidget::onCommandSent(int id, double latencyMs)
+{
+    const char *mnemonic = MP7100Protocol::commands[id].mnemonic;
+    TCLOG_DEBUG(lcProtocol, "      -> %1 written after %2 ms", mnemonic, latencyMs);
+    ui->commandLatency->setText(QString("%1 %2 ms").arg(mnemonic).arg(latencyMs, 0, 'f', 1));
+}
+
+void MainWidget::onLogRowsAboutToBeInserted()
+{
+    // follow new messages unless the user has scrolled up
+    QScrollBar *sb = ui->textMessage->verticalScrollBar();
+    m_logFollow = sb->value() == sb->maximum();
+}
+
+void MainWidget::onLogRowsInserted()
+{
+    if (m_logFollow)
+        ui->textMessage->scrollToBottom();
+}
+
+void MainWidget::takeSamples()
+{
+    // in fast acquisition mode many samples arrive per frame, all are
+    // stored but only the latest valid one is shown
+    MP7100::SAMPLE s, last;
+    bool valid = false;
+    while ((m_dev != nullptr) && m_dev->takeSample(s)) {
+        if (s.ok) {
+            m_store.append(s.t + m_devTimeOffsetNs, s.u, s.i, s.cc);
+            m_energy.add(s.t + m_devTimeOffsetNs, s.u, s.i);
+            for (auto &stats : m_stats)
+                stats.add(s.t + m_devTimeOffsetNs, s.u, s.i);
+            if (m_capture.isOpen() && !m_capture.append(s.t + m_devTimeOffsetNs, s.u, s.i, s.cc))
+                ui->record->setChecked(false);
+            last = s;
+            valid = true;
+        }
+    }
+    if (valid) {
+        ui->trend->samplesAppended();
+        updateEnergy();
+        updateStatistics();
+        setDisplayVoltageCurrent(last.u, last.i, last.cc, last.ok);
+    }
 }
 
 void MainWidget::setDisplayVoltageCurrent(double u, double i, bool cc, bool ok)
 {
-    m_state = DisplayVoltageCurrentReceived;
     if (ok) {
         triggerWatchdog();
         ui->measuredVolts->setText(QString("%1 V").arg(u, 5, 'f', 2));
@@ -244,13 +322,43 @@ void MainWidget::setDisplayVoltageCurrent(double u, double i, bool cc, bool ok)
     }
 }
 
+void MainWidget::updateEnergy()
+{
+    const EnergyMeter::SESSION &s = m_energy.session();
+    const qint64 secs = s.durationNs/1000000000;
+    ui->energy->setText(QString("%1 Wh  %2 Ah  %3:%4:%5").arg(s.wh, 0, 'f', 4).arg(s.ah, 0, 'f', 4)
+                        .arg(secs/3600).arg(secs/60%60, 2, 10, QChar('0')).arg(secs%60, 2, 10, QChar('0')));
+    QStringList history;
+    for (const auto &h : m_energy.history()) {
+        history << QString("%1: %2 Wh, %3 Ah, %4 s").arg(h.start.toString("yyyy-MM-dd hh:mm:ss"))
+                       .arg(h.wh, 0, 'f', 4).arg(h.ah, 0, 'f', 4).arg(h.durationNs/1e9, 0, 'f', 0);
+    }
+    ui->energy->setToolTip(history.isEmpty() ? tr("charge and energy since the output was switched on")
+                                             : history.join("\n"));
+}
+
+void MainWidget::updateStatistics()
+{
+    const WindowStats &stats = m_stats[qBound(0, ui->statsWindow->currentIndex(), STATS_WINDOWS-1)];
+    auto line = [&stats](WindowStats::QUANTITY q, const char *unit, int digits) {
+        const WindowStats::RESULT r = stats.result(q);
+        return QString("%1 +/- %2 %3  [%4 .. %5]").arg(r.mean, 0, 'f', digits).arg(r.stddev, 0, 'f', digits+1)
+                .arg(unit).arg(r.min, 0, 'f', digits).arg(r.max, 0, 'f', digits);
+    };
+    ui->stats->setText(line(WindowStats::Voltage, "V", 2) + "\n" + line(WindowStats::Current, "A", 3)
+                       + "\n" + line(WindowStats::Power, "W", 3));
+    ui->stats->setToolTip(tr("mean +/- standard deviation [minimum .. maximum] of %1 samples").arg(stats.count()));
+}
+
 void MainWidget::setMinimumVoltageCurrent(double u, double i, bool ok)
 {
-    m_state = MinimumVoltageCurrentReceived;
+    queryFinished();
     if (ok) {
         triggerWatchdog();
         qInfo() << "minimum voltage:" << u << "V";
         qInfo() << "minimum current:" << i << "A";
+        m_limits.minU = u;
+        m_limits.minI = i;
         SilentCall(ui->setVolts)->setMinimum(u);
         SilentCall(ui->setAmps)->setMinimum(u);
     } else {
@@ -261,11 +369,13 @@ void MainWidget::setMinimumVoltageCurrent(double u, double i, bool ok)
 
 void MainWidget::setMaximumVoltageCurrent(double u, double i, bool ok)
 {
-    m_state = MaximumVoltageCurrentReceived;
+    queryFinished();
     if (ok) {
         triggerWatchdog();
         qInfo() << "maximum voltage:" << u << "V";
         qInfo() << "maximum current:" << i << "A";
+        m_limits.maxU = u;
+        m_limits.maxI = i;
         SilentCall(ui->setVolts)->setMaximum(u);
         SilentCall(ui->setAmps)->setMaximum(i);
     } else {
@@ -276,7 +386,6 @@ void MainWidget::setMaximumVoltageCurrent(double u, double i, bool ok)
 
 void MainWidget::setVoltageCurrentSet(double u, double i, bool ok)
 {
-    m_state = SetVoltageCurrentReceived;
     if (ok) {
         triggerWatchdog();
         if (!m_setVoltageChanged) {
@@ -290,7 +399,6 @@ void MainWidget::setVoltageCurrentSet(double u, double i, bool ok)
 
 void MainWidget::setOnOff(bool on, bool ok)
 {
-    m_state = GetOnOffReceived;
     if (ok) {
         triggerWatchdog();
         if (!m_setOnOff) {
@@ -300,12 +408,24 @@ void MainWidget::setOnOff(bool on, bool ok)
     }
 }
 
+void MainWidget::onOutputSwitchedOn()
+{
+    // every output on starts a new charge and energy session, also the ones
+    // of a sequence
+    const EnergyMeter::SESSION &last = m_energy.session();
+    if (last.durationNs > 0)
+        qInfo() << "session finished:" << last.wh << "Wh," << last.ah << "Ah in" << last.durationNs/1e9 << "s";
+    m_energy.startSession();
+    updateEnergy();
+}
+
 void MainWidget::on_onoff_toggled(bool checked)
 {
     m_setOnOff = true;
     m_newOnOff = checked;
     qInfo() << "switch " << (checked ? "ON" : "OFF");
     setOnOffText(checked);
+    sendUserCommands();
 }
 
 
@@ -316,6 +436,10 @@ void MainWidget::on_setVA_clicked()
     m_setVA = true;
     qInfo() << "set voltage to" << m_newVoltage << "V";
     qInfo() << "set current to" << m_newCurrent << "A";
+    sendUserCommands();
+    // the set values are the limits of the regulation
+    if (ui->regulationMode->currentIndex() != Regulator::Off)
+        applyRegulation();
 }
 
 void MainWidget::on_setVolts_valueChanged(double x)
@@ -367,8 +491,14 @@ void MainWidget::reconnectDevice()
 
 void MainWidget::disconnectDevice()
 {
-    delete m_dev;
+    if (m_dev != nullptr) {
+        // the device lives in the I/O thread and must be deleted there
+        disconnect(m_dev, nullptr, this, nullptr);
+        m_dev->deleteLater();
+        m_dev = nullptr;
+    }
     m_state = Uninitialized;
+    m_pendingQueries = 0;
     killTimer(m_idUpdateTimer);
     m_idUpdateTimer = 0;
     killTimer(m_idWatchdogTimer);
@@ -377,12 +507,32 @@ void MainWidget::disconnectDevice()
 
 void MainWidget::connectDevice()
 {
-    m_dev = new MP7100(this);
-    connect(m_dev, &MP7100::displayVoltageCurrentGet, this, &MainWidget::setDisplayVoltageCurrent);
+    m_dev = new MP7100(m_portName);
+    // the sample timestamps of every device start at its construction
+    m_devTimeOffsetNs = m_clock.nsecsElapsed() - m_dev->elapsedNs();
+    m_dev->moveToThread(&m_ioThread);
+    connect(m_dev, &MP7100::samplesAvailable, this, &MainWidget::takeSamples);
     connect(m_dev, &MP7100::minimumVoltageCurrentGet, this, &MainWidget::setMinimumVoltageCurrent);
     connect(m_dev, &MP7100::maximumVoltageCurrentGet, this, &MainWidget::setMaximumVoltageCurrent);
     connect(m_dev, &MP7100::setVoltageCurrentGet, this, &MainWidget::setVoltageCurrentSet);
     connect(m_dev, &MP7100::onoffGet, this, &MainWidget::setOnOff);
+    connect(m_dev, &MP7100::triggerFired, this, &MainWidget::onTriggerFired);
+    connect(m_dev, &MP7100::protectionTripped, this, &MainWidget::onProtectionTripped);
+    connect(m_dev, &MP7100::commandSent, this, &MainWidget::onCommandSent);
+    connect(m_dev, &MP7100::sequenceProgress, this, &MainWidget::onSequenceProgress);
+    connect(m_dev, &MP7100::sequenceFinished, this, &MainWidget::onSequenceFinished);
+    connect(m_dev, &MP7100::regulationStopped, this, &MainWidget::onRegulationStopped);
+    connect(m_dev, &MP7100::outputSwitchedOn, this, &MainWidget::onOutputSwitchedOn);
+    // neither does a regulation
+    SilentCall(ui->regulationMode)->setCurrentIndex(Regulator::Off);
+    ui->regulationValue->setEnabled(false);
+    // a sequence does not survive a reconnect
+    SilentCall(ui->sequence)->setChecked(false);
+    updateProtection();
+    // triggers live in the device, arm them again after a reconnect
+    if (ui->triggerArm->isChecked())
+        armTrigger();
+    QMetaObject::invokeMethod(m_dev, "open", Qt::QueuedConnection);
     QTimer::singleShot(250, this, &MainWidget::startDevice);
 }
 
@@ -390,15 +540,31 @@ void MainWidget::connectDevice()
 void MainWidget::triggerWatchdog()
 {
     killTimer(m_idWatchdogTimer);
-    qDebug() << "   -> trigger watchdog";
+    TCLOG_DEBUG(lcGui, "   -> trigger watchdog");
     m_idWatchdogTimer = startTimer(WATCHDOG_MS);
     updateIndicator(true);
 }
 
+void MainWidget::queryFinished()
+{
+    if (m_pendingQueries > 0)
+        m_pendingQueries--;
+}
+
+void MainWidget::startPolling()
+{
+    if (ui->fastAcquisition->isChecked()) {
+        m_dev->setAcquisition(true, SLOW_POLL_MS);
+    } else {
+        m_dev->setAcquisition(false);
+        m_dev->setPolling(UPDATE_MS);
+    }
+}
+
 
 void MainWidget::on_alwaysOnTop_toggled(bool checked)
 {
-    qDebug() << "always on top =" << checked;
+    qCDebug(lcGui) << "always on top =" << checked;
     QSettings cfg;
     cfg.beginGroup(GRP_MP7100);
     cfg.setValue(CFG_ALWAYS_ON_TOP, checked);
@@ -407,14 +573,309 @@ void MainWidget::on_alwaysOnTop_toggled(bool checked)
     show();
 }
 
+void MainWidget::on_fastAcquisition_toggled(bool checked)
+{
+    qInfo() << "fast acquisition" << (checked ? "ON" : "OFF");
+    QSettings cfg;
+    cfg.beginGroup(GRP_MP7100);
+    cfg.setValue(CFG_FAST_ACQUISITION, checked);
+    cfg.endGroup();
+    if ((m_dev != nullptr) && (m_state == Polling))
+        startPolling();
+}
+
+void MainWidget::on_protect_toggled(bool checked)
+{
+    qInfo() << "protection" << (checked ? "ON" : "OFF");
+    updateProtection();
+}
+
+void MainWidget::updateLogCategories()
+{
+    QStringList debug;
+    if (ui->logSerial->isChecked())
+        debug << "serial";
+    if (ui->logProtocol->isChecked())
+        debug << "protocol";
+    if (ui->logGui->isChecked())
+        debug << "gui";
+    if (ui->logPower->isChecked())
+        debug << "power";
+    LogCategories::setDebug(debug);
+    m_log.setShowDebug(!debug.isEmpty());
+    QSettings cfg;
+    cfg.beginGroup(GRP_MP7100);
+    cfg.setValue(CFG_LOG_CATEGORIES, debug);
+    cfg.endGroup();
+    qInfo() << "debug messages:" << (debug.isEmpty() ? QString("OFF") : debug.join(", "));
+}
+
+void MainWidget::updateProtection()
+{
+    const bool on = ui->protect->isChecked();
+    QSettings cfg;
+    cfg.beginGroup(GRP_MP7100);
+    cfg.setValue(CFG_PROTECT, on);
+    cfg.setValue(CFG_PROTECT_AMPS, ui->protectAmps->value());
+    cfg.setValue(CFG_PROTECT_WATTS, ui->protectWatts->value());
+    cfg.endGroup();
+    if (m_dev != nullptr)
+        m_dev->setProtection(on ? ui->protectAmps->value() : 0., on ? ui->protectWatts->value() : 0.);
+}
+
+void MainWidget::onProtectionTripped(double u, double i, double writeMs, double ackMs, bool ok)
+{
+    qWarning().noquote() << QString("protection tripped at %1 V, %2 A: SOUT0 written after %3 ms, %4 after %5 ms")
+                            .arg(u, 0, 'f', 3).arg(i, 0, 'f', 3).arg(writeMs, 0, 'f', 1)
+                            .arg(ok ? "confirmed" : "FAILED").arg(ackMs, 0, 'f', 1);
+    ui->tripLatency->setText(QString("%1 / %2 ms").arg(writeMs, 0, 'f', 1).arg(ackMs, 0, 'f', 1));
+    // the output has been switched off by the device thread already
+    m_setOnOff = false;
+    m_newOnOff = false;
+    SilentCall(ui->onoff)->setChecked(false);
+    setOnOffText(false);
+}
+
+void MainWidget::on_sequence_toggled(bool checked)
+{
+    if (!checked) {
+        qInfo() << "stopping sequence";
+        if (m_dev != nullptr)
+            m_dev->stopSequence();
+        return;
+    }
+    if (!startSequence())
+        SilentCall(ui->sequence)->setChecked(false);
+}
+
+bool MainWidget::startSequence()
+{
+    if ((m_dev == nullptr) || (m_state != Polling)) {
+        qWarning() << "device not ready, cannot run a sequence";
+        return false;
+    }
+    QSettings cfg;
+    cfg.beginGroup(GRP_MP7100);
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Run Sequence"), cfg.value(CFG_SEQUENCE_FILE).toString(),
+                                                          tr("Sequences (*.seq *.txt);;All Files (*)"));
+    if (fileName.isEmpty())
+        return false;
+    cfg.setValue(CFG_SEQUENCE_FILE, fileName);
+    cfg.endGroup();
+    QFile f(fileName);
+    if (!f.open(QFile::ReadOnly | QFile::Text)) {
+        qWarning() << "cannot open sequence" << fileName << f.errorString();
+        return false;
+    }
+    QVector<Sequencer::STEP> steps;
+    QString error;
+    if (!Sequencer::compile(QString::fromUtf8(f.readAll()), m_store.model(), steps, error)) {
+        QMessageBox::warning(this, qApp->applicationDisplayName(), QString("%1: %2").arg(QFileInfo(fileName).fileName()).arg(error));
+        qWarning() << "sequence" << fileName << error;
+        return false;
+    }
+    qInfo() << "running sequence" << fileName << "with" << steps.size() << "steps in" << steps.last().tMs/1000. << "s";
+    ui->sequenceStatus->setText(QString("0 / %1").arg(steps.size()));
+    m_dev->startSequence(steps);
+    return true;
+}
+
+void MainWidget::onSequenceProgress(int step, int count, double jitterMs)
+{
+    ui->sequenceStatus->setText(QString("%1 / %2, jitter %3 ms").arg(step + 1).arg(count).arg(jitterMs, 0, 'f', 1));
+}
+
+void MainWidget::onSequenceFinished(int sent, int skipped, double meanMs, double maxAbsMs, double stddevMs, bool aborted)
+{
+    const QString result = QString("%1 steps sent, %2 skipped, jitter %3 +/- %4 ms, max %5 ms")
+            .arg(sent).arg(skipped).arg(meanMs, 0, 'f', 1).arg(stddevMs, 0, 'f', 1).arg(maxAbsMs, 0, 'f', 1);
+    qInfo().noquote() << (aborted ? "sequence aborted:" : "sequence finished:") << result;
+    ui->sequenceStatus->setText(result);
+    SilentCall(ui->sequence)->setChecked(false);
+}
+
+void MainWidget::on_regulationMode_currentIndexChanged(int index)
+{
+    ui->regulationValue->setEnabled(index != Regulator::Off);
+    ui->regulationValue->setSuffix((index == Regulator::ConstantPower) ? " W" : " Ohm");
+    applyRegulation();
+    if (index == Regulator::Off) {
+        // back to the set values of the user
+        m_newVoltage = ui->setVolts->value();
+        m_newCurrent = ui->setAmps->value();
+        m_setVA = true;
+        sendUserCommands();
+    }
+}
+
+void MainWidget::applyRegulation()
+{
+    if (m_dev == nullptr)
+        return;
+    QSettings cfg;
+    cfg.beginGroup(GRP_MP7100);
+    Regulator::CONFIG c;
+    c.mode = static_cast<Regulator::MODE>(ui->regulationMode->currentIndex());
+    c.currentLimit = ui->setAmps->value();
+    c.maxVoltage = ui->setVolts->value();
+    if (c.mode == Regulator::ConstantPower) {
+        c.target = ui->regulationValue->value();
+        c.resistance = 0.;
+    } else {
+        c.target = ui->setVolts->value();
+        c.resistance = ui->regulationValue->value();
+    }
+    c.kp = cfg.value(CFG_REGULATION_KP, DEFAULT_REGULATION_KP).toDouble();
+    c.ki = cfg.value(CFG_REGULATION_KI, DEFAULT_REGULATION_KI).toDouble();
+    c.maxRate = cfg.value(CFG_REGULATION_RATE, DEFAULT_REGULATION_RATE).toDouble();
+    cfg.endGroup();
+    qInfo() << "regulation:" << ui->regulationMode->currentText() << ui->regulationValue->value()
+            << "max" << c.maxVoltage << "V," << c.currentLimit << "A";
+    m_dev->setRegulation(c);
+    ui->regulationStats->clear();
+}
+
+void MainWidget::onRegulationStopped()
+{
+    qWarning() << "regulation stopped";
+    SilentCall(ui->regulationMode)->setCurrentIndex(Regulator::Off);
+    ui->regulationValue->setEnabled(false);
+}
+
+void MainWidget::updateRegulationStats()
+{
+    const Regulator::STATS s = m_dev->regulationStats();
+    if (s.updates == 0)
+        return;
+    ui->regulationStats->setText(QString("%1 Hz, %2 +/- %3 ms, latency %4 ms (max %5), limited %6%")
+                                 .arg(1000./s.intervalMs, 0, 'f', 1)
+                                 .arg(s.intervalMs, 0, 'f', 1).arg(s.intervalStddevMs, 0, 'f', 1)
+                                 .arg(s.latencyMs, 0, 'f', 1).arg(s.maxLatencyMs, 0, 'f', 1)
+                                 .arg(100.*s.limited/s.updates, 0, 'f', 0));
+}
+
+void MainWidget::on_saveLog_clicked()
+{
+    // the messages are written by the logger thread
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+    const QString fileName = dir.filePath(QString("MP7100_%1.log").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    qInfo() << "saving log to" << fileName;
+    reinterpret_cast<TApp*>(qApp)->saveLog(fileName);
+}
+
+void MainWidget::on_record_toggled(bool checked)
+{
+    if (!checked) {
+        if (m_capture.isOpen())
+            qInfo() << "capture stopped," << m_capture.count() << "samples recorded";
+        m_capture.close();
+        return;
+    }
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+    const QString fileName = dir.filePath(QString("MP7100_%1.mp7cap").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    if (m_capture.open(fileName, MP7100Protocol::models[0], m_limits)) {
+        qInfo() << "capturing to" << fileName;
+    } else {
+        qWarning() << "cannot create capture file" << fileName << m_capture.errorString();
+        SilentCall(ui->record)->setChecked(false);
+    }
+}
+
+void MainWidget::armTrigger()
+{
+    TriggerEngine::TRIGGER t;
+    t.id = TRIGGER_ID;
+    t.condition = static_cast<TriggerEngine::CONDITION>(ui->triggerCondition->currentIndex());
+    t.level = ui->triggerLevel->value();
+    t.samples = ui->triggerSamples->value();
+    t.actions = ui->triggerAction->currentData().toInt();
+    m_dev->armTrigger(t);
+}
+
+void MainWidget::on_triggerArm_toggled(bool checked)
+{
+    ui->triggerCondition->setEnabled(!checked);
+    ui->triggerLevel->setEnabled(!checked);
+    ui->triggerSamples->setEnabled(!checked);
+    ui->triggerAction->setEnabled(!checked);
+    if (m_dev == nullptr)
+        return;
+    if (checked) {
+        qInfo() << "trigger armed:" << ui->triggerCondition->currentText() << ui->triggerLevel->value()
+                << "for" << ui->triggerSamples->value() << "samples ->" << ui->triggerAction->currentText();
+        armTrigger();
+    } else {
+        m_dev->disarmTrigger(TRIGGER_ID);
+    }
+}
+
+void MainWidget::onTriggerFired(int id, int actions, qint64 tNs)
+{
+    Q_UNUSED(id)
+    const qint64 t = tNs + m_devTimeOffsetNs;
+    qWarning() << "trigger fired:" << ui->triggerCondition->currentText() << ui->triggerLevel->value();
+    SilentCall(ui->triggerArm)->setChecked(false);
+    on_triggerArm_toggled(false);
+    if (actions & TriggerEngine::ActionOutputOff) {
+        // the device has already been switched off, drop a pending switch on
+        m_setOnOff = false;
+        m_newOnOff = false;
+        SilentCall(ui->onoff)->setChecked(false);
+        setOnOffText(false);
+    }
+    if ((actions & TriggerEngine::ActionMark) && m_capture.isOpen())
+        m_capture.mark(t);
+    if (actions & TriggerEngine::ActionSnapshot)
+        QTimer::singleShot(SNAPSHOT_POST_MS, this, [this, t]() { saveSnapshot(t); });
+}
+
+void MainWidget::saveSnapshot(qint64 tNs)
+{
+    const quint32 ms = m_store.toMs(tNs);
+    const SampleStore::RANGE r = m_store.range(ms > SNAPSHOT_PRE_MS ? ms - SNAPSHOT_PRE_MS : 0, ms + SNAPSHOT_POST_MS);
+    if (r.begin == r.end) {
+        qWarning() << "snapshot: no samples";
+        return;
+    }
+    const MP7100Protocol::MODEL &model = m_store.model();
+    TRACE_HEADER h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version = TRACE_VERSION;
+    h.voltageScale = model.voltageScale;
+    h.currentScale = model.currentScale;
+    h.minU = static_cast<quint32>(m_limits.minU*model.voltageScale + 0.5);
+    h.minI = static_cast<quint32>(m_limits.minI*model.currentScale + 0.5);
+    h.maxU = static_cast<quint32>(m_limits.maxU*model.voltageScale + 0.5);
+    h.maxI = static_cast<quint32>(m_limits.maxI*model.currentScale + 0.5);
+    const quint32 t0 = m_store.timeMs(r.begin);
+    h.startMs = QDateTime::currentMSecsSinceEpoch() - (m_store.lastTimeMs() - t0);
+    h.count = r.end - r.begin;
+    QByteArray data;
+    TraceEncoder encoder(data);
+    for (quint64 n = r.begin; n < r.end; ++n)
+        encoder.append(m_store.timeMs(n) - t0, m_store.rawVoltage(n), m_store.rawCurrent(n), m_store.cc(n));
+    encoder.finish();
+
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+    QFile f(dir.filePath(QString("MP7100_trigger_%1.mp7trc").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"))));
+    if (f.open(QFile::WriteOnly | QFile::Truncate)
+            && (f.write(reinterpret_cast<const char*>(&h), sizeof(h)) == sizeof(h))
+            && (f.write(data) == data.size())) {
+        qInfo() << "snapshot of" << h.count << "samples saved to" << f.fileName();
+    } else {
+        qWarning() << "cannot save snapshot" << f.fileName() << f.errorString();
+    }
+}
+
 void MainWidget::onSuspend()
 {
-    qInfo() << "suspending DP700 communications";
+    qCInfo(lcPower) << "suspending DP700 communications";
     disconnectDevice();
 }
 
 void MainWidget::onResume()
 {
-    qInfo() << "resuming DP700 communications";
+    qCInfo(lcPower) << "resuming DP700 communications";
     connectDevice();
 }
@@ -14,6 +14,13 @@
 #define MAINWIDGET_H
 
 #include "tmainwidget.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include "samplestore.h"
+#include "capturefile.h"
+#include "energymeter.h"
+#include "windowstats.h"
+#include "tlogmodel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWidget; }
@@ -26,21 +33,30 @@ class MainWidget : public TMainWidget
     Q_OBJECT
 
 public:
-    MainWidget(QWidget *parent = nullptr);
+    // an empty portName selects the serial port stored in the settings, a
+    // null logCategories the debug log categories stored in the settings
+    MainWidget(const QString &portName = QString(), const QString &logCategories = QString(), QWidget *parent = nullptr);
     ~MainWidget();
 
+    // sliding window statistics of the measured values, window 0..STATS_WINDOWS-1
+    enum { STATS_WINDOWS = 3 };
+    const WindowStats &statistics(int window) const { return m_stats[window]; }
+
 protected:
     void timerEvent(QTimerEvent *event) override;
 
 
 private slots:
     void startDevice();
-    void on_messageAdded(const QString &msg);
+    void onLogRowsAboutToBeInserted();
+    void onLogRowsInserted();
+    void takeSamples();
     void setDisplayVoltageCurrent(double u, double i, bool cc, bool ok);
     void setMinimumVoltageCurrent(double u, double i, bool ok);
     void setMaximumVoltageCurrent(double u, double i, bool ok);
     void setVoltageCurrentSet(double u, double i, bool ok);
     void setOnOff(bool on, bool ok);
+    void onOutputSwitchedOn();
     void onSuspend();
     void onResume();
 
@@ -52,22 +68,27 @@ private slots:
     void updateIndicator(bool connected);
 
     void on_alwaysOnTop_toggled(bool checked);
+    void on_fastAcquisition_toggled(bool checked);
+    void on_record_toggled(bool checked);
+    void on_saveLog_clicked();
+    void on_triggerArm_toggled(bool checked);
+    void onTriggerFired(int id, int actions, qint64 tNs);
+    void on_protect_toggled(bool checked);
+    void onProtectionTripped(double u, double i, double writeMs, double ackMs, bool ok);
+    void onCommandSent(int id, double latencyMs);
+    void on_sequence_toggled(bool checked);
+    void on_regulationMode_currentIndexChanged(int index);
+    void onRegulationStopped();
+    void onSequenceProgress(int step, int count, double jitterMs);
+    void onSequenceFinished(int sent, int skipped, double meanMs, double maxAbsMs, double stddevMs, bool aborted);
 
 private:
     Ui::MainWidget *ui;
 
     typedef enum {
         Uninitialized,
-        MinimumVoltageCurrentWaiting,
-        MinimumVoltageCurrentReceived,
-        MaximumVoltageCurrentWaiting,
-        MaximumVoltageCurrentReceived,
-        DisplayVoltageCurrentWaiting,
-        DisplayVoltageCurrentReceived,
-        SetVoltageCurrentWaiting,
-        SetVoltageCurrentReceived,
-        GetOnOffWaiting,
-        GetOnOffReceived,
+        LimitsWaiting,
+        Polling,
     } State;
 
     void setOnOffText(bool on);
@@ -75,10 +96,26 @@ private:
     void disconnectDevice();
     void connectDevice();
     void triggerWatchdog();
-
-    bool            m_lastCommandErrorRequest;
+    void queryFinished();
+    void startPolling();
+    void updateEnergy();
+    void updateStatistics();
+    void sendUserCommands();
+    bool startSequence();
+    void applyRegulation();
+    void updateRegulationStats();
+    void armTrigger();
+    void updateProtection();
+    void updateLogCategories();
+    void saveSnapshot(qint64 tNs);
+
+    TLogModel       m_log;          // newest log messages shown in textMessage
+    bool            m_logFollow;    // scroll to new messages
+    QString         m_portName;
+    QThread         m_ioThread;
     MP7100          *m_dev;
     State           m_state;
+    int             m_pendingQueries;
     int             m_idUpdateTimer;
     int             m_idWatchdogTimer;
     bool            m_setOnOff;
@@ -89,6 +126,13 @@ private:
     double          m_newVoltage;
     double          m_newCurrent;
     int             m_indicatorCount, m_indicatorInc;
+    SampleStore     m_store;        // history of all measured values
+    QElapsedTimer   m_clock;        // time base of m_store across reconnects
+    qint64          m_devTimeOffsetNs;  // m_clock time - device sample time
+    CaptureFile::LIMITS m_limits;   // device limits, stored in capture files
+    CaptureWriter   m_capture;
+    EnergyMeter     m_energy;       // output on sessions, kept across reconnects
+    WindowStats     m_stats[STATS_WINDOWS];
 };
 
 #endif // MAINWIDGET_H
@@ -11,282 +11,743 @@
 // 2023-2-27  tt  Initial version created
 // ***************************************************************************
 #include "mp7100.h"
-#include <QMutexLocker>
+#include "mp7100protocol.h"
+#include "tlog.h"
+#include "logcategories.h"
 #include <QDebug>
 #include <QTimerEvent>
+#include <QThread>
 
-MP7100::MP7100(QObject *parent)
-    : SerDev("COM12", 9600, parent)
-    , m_state(Idle)
-    , m_U(0.)
-    , m_I(0.)
+// time to wait for the complete reply of a command before its round trip
+// time is known, and upper limit of the adaptive timeout
+#define COMMAND_TIMEOUT_MS  1000
+// lower limit of the adaptive timeout
+#define MIN_TIMEOUT_MS      20
+// jitter of the serial link and the device allowed on top of the measured
+// round trip time variation, in characters
+#define JITTER_CHARS        16
+// time without received data before a command is retransmitted, in characters
+#define QUIET_CHARS         32
+// number of retransmissions before a command fails
+#define MAX_RETRIES         1
+// maximum number of commands waiting to be sent
+#define MAX_QUEUED_COMMANDS 64
+
+
+#define MP7100_RESULT_HANDLER(id, mnemonic, args, digits, fields, result) \
+    [](MP7100 *dev, bool ok) { dev->emitResult(&MP7100::result, ok); },
+const MP7100::RESULT_HANDLER MP7100::s_resultHandlers[MP7100Protocol::CommandCount] = {
+    MP7100_COMMANDS(MP7100_RESULT_HANDLER)
+};
+#undef MP7100_RESULT_HANDLER
+
+
+MP7100::MP7100(const QString &portName, QObject *parent, const MP7100Protocol::MODEL &model)
+    : SerDev(portName, 9600, parent)
+    , m_model(model)
+    , m_command(MP7100Protocol::CommandCount)
+    , m_phase(Idle)
+    , m_U(0)
+    , m_I(0)
     , m_On(false)
     , m_CC(false)
+    , m_valid(false)
     , m_idTimer(0)
+    , m_idPollTimer(0)
+    , m_pollPending(0)
+    , m_rxTimeNs(0)
+    , m_doneWriteNs(0)
+    , m_doneRetries(0)
+    , m_acquiring(false)
+    , m_acquirePending(false)
+    , m_tripI(0)
+    , m_tripP(0)
+    , m_tripped(false)
+    , m_idSequenceTimer(0)
+    , m_regulatedU(0)
 {
+    m_clock.start();
+    m_fired.reserve(8);
+    for (auto &rtt : m_rtt) {
+        rtt.srttMs = 0.;
+        rtt.rttvarMs = 0.;
+        rtt.lastMs = 0.;
+        rtt.timeoutMs = COMMAND_TIMEOUT_MS;
+        rtt.samples = 0;
+        rtt.retries = 0;
+        rtt.timeouts = 0;
+    }
 }
 
 
-bool MP7100::setOnOff(bool on)
+bool MP7100::setOnOff(bool on, const Callback &done)
 {
-    return sendCommand(QString("SOUT%1").arg(on ? "1" : "0").toLatin1(), Idle, SetOnOff);
+    return postRequest(MP7100Protocol::CmdSetOnOff, done, on ? 1 : 0);
 }
 
-bool MP7100::getOnOff()
+bool MP7100::getOnOff(const Callback &done)
 {
-    return sendCommand(QString("GOUT").toLatin1(), Idle, GetOnOff);
+    return postRequest(MP7100Protocol::CmdGetOnOff, done);
 }
 
-bool MP7100::setVoltageCurrent(double u, double i)
+bool MP7100::setVoltageCurrent(double u, double i, const Callback &done)
 {
-    return sendCommand(QString("SETD%1%2")
-                           .arg(static_cast<unsigned>(u*100),  4, 10, QLatin1Char('0'))
-                           .arg(static_cast<unsigned>(i*1000), 4, 10, QLatin1Char('0')).toLatin1(),
-                       Idle, SetVoltageCurrent);
+    return postRequest(MP7100Protocol::CmdSetVoltageCurrent, done, toVoltage(u), toCurrent(i));
 }
 
-bool MP7100::getDisplayVoltageCurrent()
+bool MP7100::getDisplayVoltageCurrent(const Callback &done)
 {
-    return sendCommand(QString("GETD").toLatin1(), Idle, GetDisplayVoltageCurrent);
+    return postRequest(MP7100Protocol::CmdGetDisplayVoltageCurrent, done);
 }
 
-bool MP7100::getSetVoltageCurrent()
+bool MP7100::getSetVoltageCurrent(const Callback &done)
 {
-    return sendCommand(QString("GETS").toLatin1(), Idle, GetSetVoltageCurrent);
+    return postRequest(MP7100Protocol::CmdGetSetVoltageCurrent, done);
 }
 
-bool MP7100::getMinimumVoltageCurrent()
+bool MP7100::getMinimumVoltageCurrent(const Callback &done)
 {
-    return sendCommand(QString("GMIN").toLatin1(), Idle, GetMinimumVoltageCurrent);
+    return postRequest(MP7100Protocol::CmdGetMinimumVoltageCurrent, done);
 }
 
-bool MP7100::getMaximumVoltageCurrent()
+bool MP7100::getMaximumVoltageCurrent(const Callback &done)
 {
-    return sendCommand(QString("GMAX").toLatin1(), Idle, GetMaximumVoltageCurrent);
+    return postRequest(MP7100Protocol::CmdGetMaximumVoltageCurrent, done);
 }
 
-void MP7100::decodeBuffer(QByteArray &buffer)
+void MP7100::setPolling(int intervalMs)
 {
-    // check if there is a reply terminator in the received data
-    int inx;
-    while ((inx = buffer.indexOf('\r')) >= 0) {
-        decodeCommand(buffer.left(inx), false);
-        buffer = buffer.mid(inx+1);
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, "setPolling", Qt::QueuedConnection, Q_ARG(int, intervalMs));
+        return;
+    }
+    if (m_idPollTimer != 0) {
+        killTimer(m_idPollTimer);
+        m_idPollTimer = 0;
+    }
+    if (intervalMs > 0) {
+        m_idPollTimer = startTimer(intervalMs, Qt::PreciseTimer);
+        poll();
     }
 }
 
-void MP7100::decodeCommand(const QByteArray &buffer, bool timeout)
+void MP7100::setAcquisition(bool on, int slowIntervalMs)
 {
-//    qDebug() << "+++ MP7100::decodeCommand(buffer =" << buffer << ") +++";
-//    qDebug() << "      m_state =" << m_state;
-    if (!buffer.isEmpty()) {
-        QList<QByteArray> params;
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, "setAcquisition", Qt::QueuedConnection, Q_ARG(bool, on), Q_ARG(int, slowIntervalMs));
+        return;
+    }
+    m_acquiring = on;
+    setPolling(on ? slowIntervalMs : 0);
+    if (on)
+        acquire();
+}
 
-        switch(m_state) {
-        case SetOnOff: {
-            if (timeout) {
-                emit onoffSet(false);
-            } else {
-                emit onoffSet(buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
-        }
-        case GetOnOff: {
-            if (timeout) {
-                emit onoffGet(false, false);
-                m_state = Idle;
-            } else {
-                m_On = buffer[0]=='1';
-                m_state = GetOnOffFinal;
-            }
-            break;
-        }
-        case GetOnOffFinal: {
-            if (timeout) {
-                emit onoffGet(false, false);
-            } else {
-                emit onoffGet(m_On, buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
-        }
-        case SetVoltageCurrent: {
-            if (timeout) {
-                emit voltageCurrentSet(false);
-            } else {
-                emit voltageCurrentSet(buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
-        }
-        case GetDisplayVoltageCurrent: {
-            if (timeout) {
-                emit displayVoltageCurrentGet(0., 0., false, false);
-                m_state = Idle;
-            } else {
-                params = buffer.split(';');
-                if (params.size()>0) {
-                    m_U = params[0].toUInt()/100.;
-                } else {
-                    m_U = 0.;
-                }
-                if (params.size()>1) {
-                    m_I = params[1].toUInt()/1000.;
-                } else {
-                    m_I = 0.;
-                }
-                if (params.size()>2) {
-                    m_CC = params[2]=="1";
-                } else {
-                    m_CC = false;
-                }
-                m_state = GetDisplayVoltageCurrentFinal;
-            }
-            break;
-        }
-        case GetDisplayVoltageCurrentFinal: {
-            if (timeout) {
-                emit displayVoltageCurrentGet(0., 0., false, false);
-            } else {
-                emit displayVoltageCurrentGet(m_U, m_I, m_CC, buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
-        }
+bool MP7100::takeSample(SAMPLE &sample)
+{
+    if (m_samples.pop(sample))
+        return true;
+    // queue is drained: re-arm the notification and catch a sample that
+    // may have been pushed before the flag was cleared
+    m_samplesNotified.fetchAndStoreOrdered(0);
+    return m_samples.pop(sample);
+}
 
-        case GetSetVoltageCurrent: {
-            if (timeout) {
-                emit setVoltageCurrentGet(0., 0., false);
-                m_state = Idle;
-            } else {
-                params = buffer.split(';');
-                if (params.size()>0) {
-                    m_U = params[0].toUInt()/100.;
-                } else {
-                    m_U = 0.;
-                }
-                if (params.size()>1) {
-                    m_I = params[1].toUInt()/1000.;
-                } else {
-                    m_I = 0.;
-                }
-                m_state = GetSetVoltageCurrentFinal;
-            }
-            break;
-        }
-        case GetSetVoltageCurrentFinal: {
-            if (timeout) {
-                emit setVoltageCurrentGet(0., 0., false);
-            } else {
-                emit setVoltageCurrentGet(m_U, m_I, buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
-        }
+MP7100::RTT_STATS MP7100::rttStats(MP7100Protocol::COMMAND_ID id) const
+{
+    QMutexLocker lock(&m_rttLock);
+    return m_rtt[id];
+}
 
-        case GetMinimumVoltageCurrent: {
-            if (timeout) {
-                emit minimumVoltageCurrentGet(0., 0., false);
-                m_state = Idle;
-            } else {
-                params = buffer.split(';');
-                if (params.size()>0) {
-                    m_U = params[0].toUInt()/100.;
-                } else {
-                    m_U = 0.;
-                }
-                if (params.size()>1) {
-                    m_I = params[1].toUInt()/1000.;
-                } else {
-                    m_I = 0.;
-                }
-                m_state = GetMinimumVoltageCurrentFinal;
-            }
-            break;
-        }
-        case GetMinimumVoltageCurrentFinal: {
-            if (timeout) {
-                emit minimumVoltageCurrentGet(0., 0., false);
-            } else {
-                emit minimumVoltageCurrentGet(m_U, m_I, buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
+void MP7100::armTrigger(const TriggerEngine::TRIGGER &trigger)
+{
+    QMetaObject::invokeMethod(this, [this, trigger]() { m_triggers.arm(trigger); }, Qt::QueuedConnection);
+}
+
+void MP7100::disarmTrigger(int id)
+{
+    QMetaObject::invokeMethod(this, [this, id]() { m_triggers.disarm(id); }, Qt::QueuedConnection);
+}
+
+void MP7100::evaluateTriggers()
+{
+    m_fired.clear();
+    const int actions = m_triggers.evaluate(voltage(), current(), m_CC, m_fired);
+    if (actions & TriggerEngine::ActionOutputOff)
+        sendOutputOff(Callback());
+    for (const auto &f : m_fired)
+        emit triggerFired(f.id, f.actions, m_rxTimeNs);
+}
+
+void MP7100::setProtection(double maxI, double maxP)
+{
+    // compare in model units, no conversion per sample
+    const quint32 i = (maxI > 0.) ? qMax<quint32>(1, toCurrent(maxI)) : 0;
+    const quint64 p = (maxP > 0.) ? qMax<quint64>(1, static_cast<quint64>(maxP*m_model.voltageScale*m_model.currentScale + 0.5)) : 0;
+    QMetaObject::invokeMethod(this, [this, i, p]() {
+        m_tripI = i;
+        m_tripP = p;
+    }, Qt::QueuedConnection);
+}
+
+void MP7100::startSequence(const QVector<Sequencer::STEP> &steps)
+{
+    QMetaObject::invokeMethod(this, [this, steps]() {
+        if (m_sequencer.isRunning())
+            finishSequence(true);
+        m_sequencer.start(steps, m_clock.nsecsElapsed());
+        runSequence();
+    }, Qt::QueuedConnection);
+}
+
+void MP7100::stopSequence()
+{
+    QMetaObject::invokeMethod(this, [this]() {
+        if (m_sequencer.isRunning())
+            finishSequence(true);
+    }, Qt::QueuedConnection);
+}
+
+void MP7100::runSequence()
+{
+    if (m_idSequenceTimer != 0) {
+        killTimer(m_idSequenceTimer);
+        m_idSequenceTimer = 0;
+    }
+    // issue all steps that are due, the remaining ones are issued when the
+    // timer fires. A timer may fire early, it is then simply started again.
+    qint64 nowNs = m_clock.nsecsElapsed();
+    while (m_sequencer.isRunning() && (m_sequencer.next() < m_sequencer.count())
+           && (m_sequencer.issueNs() <= nowNs)) {
+        const int n = m_sequencer.next();
+        const Sequencer::STEP &step = m_sequencer.step(n);
+        quint32 args[2] = { step.u, step.i };
+        COMMAND_ID id = MP7100Protocol::CmdSetVoltageCurrent;
+        if (step.op != Sequencer::OpSet) {
+            id = MP7100Protocol::CmdSetOnOff;
+            args[0] = (step.op == Sequencer::OpOn) ? 1 : 0;
         }
+        m_sequencer.issued();
+        if (!sendCommand(id, args, Callback(), true, nowNs, n) && m_sequencer.skipped(n))
+            finishSequence(false);
+        nowNs = m_clock.nsecsElapsed();
+    }
+    if (m_sequencer.isRunning() && (m_sequencer.next() < m_sequencer.count())) {
+        const qint64 delayMs = qMax<qint64>(0, (m_sequencer.issueNs() - nowNs)/1000000);
+        m_idSequenceTimer = startTimer(static_cast<int>(qMin<qint64>(delayMs, 1 << 30)), Qt::PreciseTimer);
+    }
+}
 
-        case GetMaximumVoltageCurrent: {
-            if (timeout) {
-                emit maximumVoltageCurrentGet(0., 0., false);
-                m_state = Idle;
-            } else {
-                params = buffer.split(';');
-                if (params.size()>0) {
-                    m_U = params[0].toUInt()/100.;
-                } else {
-                    m_U = 0.;
-                }
-                if (params.size()>1) {
-                    m_I = params[1].toUInt()/1000.;
-                } else {
-                    m_I = 0.;
+void MP7100::finishSequence(bool aborted)
+{
+    if (m_idSequenceTimer != 0) {
+        killTimer(m_idSequenceTimer);
+        m_idSequenceTimer = 0;
+    }
+    if (aborted)
+        dropSequenceCommands();
+    m_sequencer.stop();
+    const Sequencer::STATS stats = m_sequencer.stats();
+    emit sequenceFinished(stats.sent, stats.skipped, stats.meanMs, stats.maxAbsMs, stats.stddevMs, aborted);
+}
+
+void MP7100::dropSequenceCommands()
+{
+    const int first = (m_phase == Idle) ? 0 : 1;
+    for (int n = m_queue.size()-1; n >= first; --n) {
+        if (m_queue.at(n).step >= 0)
+            m_queue.removeAt(n);
+    }
+}
+
+void MP7100::setRegulation(const Regulator::CONFIG &config)
+{
+    QMetaObject::invokeMethod(this, [this, config]() {
+        QMutexLocker lock(&m_regulatorLock);
+        m_regulator.configure(config, voltage());
+        m_regulatedU = 0;
+    }, Qt::QueuedConnection);
+}
+
+Regulator::STATS MP7100::regulationStats() const
+{
+    QMutexLocker lock(&m_regulatorLock);
+    return m_regulator.stats();
+}
+
+void MP7100::regulate()
+{
+    double u;
+    bool update;
+    {
+        QMutexLocker lock(&m_regulatorLock);
+        update = m_regulator.update(m_rxTimeNs, voltage(), current(), u);
+    }
+    if (!update)
+        return;
+    // SETD is only sent if the set value changes in model units, a newer set
+    // value replaces one that has not been sent yet
+    const quint32 args[2] = { toVoltage(u), toCurrent(m_regulator.config().currentLimit) };
+    if (args[0] == m_regulatedU)
+        return;
+    if (sendCommand(MP7100Protocol::CmdSetVoltageCurrent, args, Callback(), true, m_rxTimeNs, -1, true))
+        m_regulatedU = args[0];
+}
+
+void MP7100::checkProtection()
+{
+    if (m_tripped || ((m_tripI == 0 || m_I <= m_tripI) && (m_tripP == 0 || static_cast<quint64>(m_U)*m_I <= m_tripP)))
+        return;
+    m_tripped = true;
+    const qint64 detectNs = m_rxTimeNs;
+    const double u = voltage();
+    const double i = current();
+    sendOutputOff([this, detectNs, u, i](const REPLY &reply) {
+        // the latency to the first write of SOUT0, a retransmission means the
+        // output may have stayed on for a timeout
+        const qint64 nowNs = m_clock.nsecsElapsed();
+        emit protectionTripped(u, i, (m_doneWriteNs - detectNs)/1e6, (nowNs - detectNs)/1e6,
+                               reply.ok && (m_doneRetries == 0));
+    });
+}
+
+void MP7100::updateRtt(COMMAND_ID id, qint64 rttNs)
+{
+    // smoothed round trip time and variation as used for TCP (RFC 6298)
+    const double r = rttNs/1e6;
+    QMutexLocker lock(&m_rttLock);
+    RTT_STATS &rtt = m_rtt[id];
+    if (rtt.samples == 0) {
+        rtt.srttMs = r;
+        rtt.rttvarMs = r/2.;
+    } else {
+        rtt.rttvarMs = 0.75*rtt.rttvarMs + 0.25*qAbs(rtt.srttMs - r);
+        rtt.srttMs = 0.875*rtt.srttMs + 0.125*r;
+    }
+    rtt.lastMs = r;
+    rtt.samples++;
+    // rttvar decays to 0 on a steady link, a timeout close to srtt would
+    // retransmit commands whose reply is only slightly late
+    rtt.timeoutMs = qBound<double>(MIN_TIMEOUT_MS, qMax(2.*rtt.srttMs, rtt.srttMs + 4.*rtt.rttvarMs + JITTER_CHARS*charMs()),
+                                   COMMAND_TIMEOUT_MS);
+}
+
+quint32 MP7100::toVoltage(double u) const
+{
+    return static_cast<quint32>(qMax(0., u)*m_model.voltageScale + 0.5);
+}
+
+quint32 MP7100::toCurrent(double i) const
+{
+    return static_cast<quint32>(qMax(0., i)*m_model.currentScale + 0.5);
+}
+
+bool MP7100::postRequest(COMMAND_ID id, const Callback &done, quint32 arg0, quint32 arg1)
+{
+    REQUEST r;
+    r.id = id;
+    r.args[0] = arg0;
+    r.args[1] = arg1;
+    r.done = done;
+    r.postNs = m_clock.nsecsElapsed();
+    if (thread() == QThread::currentThread()) {
+        // called from the device thread itself
+        return sendCommand(r.id, r.args, r.done, true, r.postNs);
+    }
+    if (!m_requests.push(r)) {
+        TCLOG_WARNING(lcProtocol, "request queue full, dropping %1", MP7100Protocol::commands[id].mnemonic);
+        return false;
+    }
+    // wake up the device thread unless it is already about to drain the queue
+    if (m_requestsNotified.fetchAndStoreOrdered(1) == 0)
+        QMetaObject::invokeMethod(this, "processRequests", Qt::QueuedConnection);
+    return true;
+}
+
+void MP7100::processRequests()
+{
+    m_requestsNotified.fetchAndStoreOrdered(0);
+    REQUEST r;
+    while (m_requests.pop(r)) {
+        sendCommand(r.id, r.args, r.done, true, r.postNs);
+    }
+}
+
+void MP7100::poll()
+{
+    // don't pile up polling cycles if the device is slower than the interval
+    if (m_pollPending > 0)
+        return;
+    Callback done = [this](const REPLY &) { m_pollPending--; };
+    m_pollPending = 3;
+    if (!sendCommand(MP7100Protocol::CmdGetOnOff, nullptr, done))
+        m_pollPending--;
+    // in acquisition mode the display values are read by acquire()
+    if (m_acquiring || !sendCommand(MP7100Protocol::CmdGetDisplayVoltageCurrent, nullptr, done))
+        m_pollPending--;
+    if (!sendCommand(MP7100Protocol::CmdGetSetVoltageCurrent, nullptr, done))
+        m_pollPending--;
+}
+
+void MP7100::acquire()
+{
+    // only one GETD of the chain is queued at any time, slow commands queued
+    // by poll() are sent in between
+    if (m_acquirePending)
+        return;
+    Callback done = [this](const REPLY &) {
+        m_acquirePending = false;
+        if (m_acquiring)
+            acquire();
+    };
+    m_acquirePending = sendCommand(MP7100Protocol::CmdGetDisplayVoltageCurrent, nullptr, done);
+}
+
+void MP7100::pushSample(bool ok)
+{
+    SAMPLE s;
+    s.t = ok ? m_rxTimeNs : m_clock.nsecsElapsed();
+    s.u = ok ? voltage() : 0.;
+    s.i = ok ? current() : 0.;
+    s.cc = ok ? m_CC : false;
+    s.ok = ok;
+    if (!m_samples.push(s)) {
+        TCLOG_WARNING(lcProtocol, "sample queue full, dropping sample");
+        return;
+    }
+    // notify the consumer only once until it has drained the queue
+    if (m_samplesNotified.fetchAndStoreOrdered(1) == 0)
+        emit samplesAvailable();
+}
+
+void MP7100::decodeBuffer(const char *data, int size)
+{
+    decodeCommand(data, size, false);
+}
+
+bool MP7100::decodeValues(const char *data, int size, int count)
+{
+    // data lines are either a single on/off flag or voltage;current[;cc]
+    quint32 values[3];
+    Q_ASSERT(count <= 3);
+    bool ok = MP7100Protocol::parseFields(data, size, values, count);
+    if (!ok) {
+        qCWarning(lcProtocol) << "invalid reply" << QByteArray(data, size);
+        values[0] = values[1] = values[2] = 0;
+    }
+    if (count == 1) {
+        m_On = values[0] == 1;
+        return ok && (values[0] <= 1);
+    }
+    m_U = values[0];
+    m_I = values[1];
+    m_CC = (count > 2) && (values[2] == 1);
+    return ok && ((count <= 2) || (values[2] <= 1));
+}
+
+void MP7100::decodeCommand(const char *data, int size, bool timeout)
+{
+//    qDebug() << "+++ MP7100::decodeCommand(data =" << QByteArray(data, size) << ") +++";
+//    qDebug() << "      m_phase =" << m_phase;
+    if ((size == 0) && !timeout)
+        return;
+    if (m_phase == Idle) {
+        qCWarning(lcProtocol) << "      unexpected data received";
+        return;
+    }
+    if (m_phase == Resync) {
+        // late reply of the command that has timed out, it must not be taken
+        // for the reply of the retransmission
+        TCLOG_DEBUG(lcProtocol, "dropping late reply");
+        killTimer(m_idTimer);
+        m_idTimer = startTimer(static_cast<int>(QUIET_CHARS*charMs() + 0.999), Qt::PreciseTimer);
+        return;
+    }
+    if ((m_phase == Data) && !timeout && MP7100Protocol::isOk(data, size)) {
+        // an OK without data line can't be the reply of this command
+        qCDebug(lcProtocol) << "      ignoring stray OK";
+        return;
+    }
+    if (timeout) {
+        m_U = 0;
+        m_I = 0;
+        m_On = false;
+        m_CC = false;
+        m_valid = false;
+    } else if (m_phase == Data) {
+        m_rxTimeNs = m_clock.nsecsElapsed();
+        m_valid = decodeValues(data, size, MP7100Protocol::commands[m_command].fields);
+        m_phase = Final;
+        return;
+    }
+    // final OK of a command, only valid if the data line could be decoded
+    const bool ok = !timeout && m_valid && MP7100Protocol::isOk(data, size);
+    if (m_command == MP7100Protocol::CmdGetDisplayVoltageCurrent)
+        processSample(ok);
+    s_resultHandlers[m_command](this, ok);
+    finishCommand(ok);
+//    qDebug() << "--- MP7100::decodeCommand() ---";
+}
+
+void MP7100::emitResult(void (MP7100::*signal)(bool), bool ok)
+{
+    emit (this->*signal)(ok);
+}
+
+void MP7100::emitResult(void (MP7100::*signal)(bool, bool), bool ok)
+{
+    emit (this->*signal)(m_On, ok);
+}
+
+void MP7100::emitResult(void (MP7100::*signal)(double, double, bool), bool ok)
+{
+    emit (this->*signal)(voltage(), current(), ok);
+}
+
+void MP7100::emitResult(void (MP7100::*signal)(double, double, bool, bool), bool ok)
+{
+    emit (this->*signal)(voltage(), current(), m_CC, ok);
+}
+
+void MP7100::processSample(bool ok)
+{
+    // the protection comes first, SOUT0 is sent as soon as this command has finished
+    if (ok) {
+        checkProtection();
+        // only regulate a switched on output, see poll()
+        if (m_On && m_regulator.isActive())
+            regulate();
+    }
+    // measured values are passed on to the sample queue as well
+    pushSample(ok);
+    if (!ok)
+        m_triggers.reset();
+    else if (!m_triggers.isEmpty())
+        evaluateTriggers();
+}
+
+void MP7100::timerEvent(QTimerEvent *event)
+{
+    if (m_idTimer == event->timerId()) {
+        killTimer(m_idTimer);
+        m_idTimer = 0;
+        commandTimeout();
+    } else if (m_idPollTimer == event->timerId()) {
+        poll();
+    } else if (m_idSequenceTimer == event->timerId()) {
+        runSequence();
+    }
+}
+
+
+bool MP7100::sendCommand(COMMAND_ID id, const quint32 *args, const Callback &done, bool user, qint64 postNs, int step, bool control)
+{
+//    qDebug() << "+++ MP7100::sendCommand(id =" << id << ") +++";
+//    qDebug() << "      m_phase =" << m_phase << "queued =" << m_queue.size();
+    // the head is in flight unless the device is idle
+    const int first = (m_phase == Idle) ? 0 : 1;
+    if (user && (id == MP7100Protocol::CmdSetVoltageCurrent)) {
+        // last write wins: a newer SETD replaces one of the same source (user,
+        // sequence or regulation) that has not been sent yet
+        for (int n = first; n < m_queue.size(); ++n) {
+            COMMAND &q = m_queue[n];
+            if (q.user && (q.id == id) && (q.control == control) && ((q.step >= 0) == (step >= 0))) {
+                const Callback superseded = q.done;
+                // a step replaced by the next one is skipped, the sequence
+                // finishes if it was the last one to be sent
+                if ((q.step >= 0) && m_sequencer.isRunning() && m_sequencer.skipped(q.step))
+                    finishSequence(false);
+                q.size = MP7100Protocol::encode(id, args, q.cmd);
+                q.done = done;
+                q.postNs = postNs;
+                q.step = step;
+                if (superseded) {
+                    REPLY reply;
+                    reply.u = reply.i = 0.;
+                    reply.on = reply.cc = reply.ok = false;
+                    superseded(reply);
                 }
-                m_state = GetMaximumVoltageCurrentFinal;
+                return true;
             }
-            break;
-        }
-        case GetMaximumVoltageCurrentFinal: {
-            if (timeout) {
-                emit maximumVoltageCurrentGet(0., 0., false);
-            } else {
-                emit maximumVoltageCurrentGet(m_U, m_I, buffer.left(2)=="OK");
-            }
-            m_state = Idle;
-            break;
         }
+    }
+    if (m_queue.size() >= MAX_QUEUED_COMMANDS) {
+        TCLOG_WARNING(lcProtocol, "command queue full, dropping %1", MP7100Protocol::commands[id].mnemonic);
+        return false;
+    }
+    COMMAND c;
+    c.id = id;
+    c.size = MP7100Protocol::encode(id, args, c.cmd);
+    c.retries = 0;
+    c.done = done;
+    c.user = user;
+    c.postNs = postNs;
+    c.step = step;
+    c.control = control;
+    c.switchOn = (id == MP7100Protocol::CmdSetOnOff) && (args != nullptr) && (args[0] != 0);
+    c.writeNs = 0;
+    // user commands overtake the queued polling commands, but not each other
+    int pos = m_queue.size();
+    if (user) {
+        pos = first;
+        while ((pos < m_queue.size()) && m_queue.at(pos).user)
+            pos++;
+    }
+    m_queue.insert(pos, c);
+    // switching on again re-enables the protection
+    if (c.switchOn)
+        m_tripped = false;
+    // nothing in flight -> send immediately
+    if (m_phase == Idle)
+        startNextCommand();
+//    qDebug() << "--- MP7100::sendCommand() -> " << true << "---";
+    return true;
+}
 
-        default: {
-            m_state = Idle;
-            qWarning() << "      unexpected data received";
-            break;
+void MP7100::sendOutputOff(const Callback &done)
+{
+    // a running sequence could switch the output on again
+    if (m_sequencer.isRunning())
+        finishSequence(true);
+    if (m_regulator.isActive()) {
+        Regulator::CONFIG off = m_regulator.config();
+        off.mode = Regulator::Off;
+        {
+            QMutexLocker lock(&m_regulatorLock);
+            m_regulator.configure(off, 0.);
         }
+        emit regulationStopped();
+    }
+    // queued on/off commands are obsolete, a pending switch on must not
+    // undo the switch off
+    REPLY dropped;
+    dropped.u = dropped.i = 0.;
+    dropped.on = dropped.cc = dropped.ok = false;
+    const int first = (m_phase == Idle) ? 0 : 1;
+    for (int n = m_queue.size()-1; n >= first; --n) {
+        if (m_queue.at(n).id == MP7100Protocol::CmdSetOnOff) {
+            const COMMAND c = m_queue.takeAt(n);
+            if (c.done)
+                c.done(dropped);
         }
     }
-    //    qDebug() << "--- MP7100::decodeCommand() ---";
+    // the command in flight can't be aborted, SOUT0 is the very next frame
+    const quint32 off = 0;
+    COMMAND c;
+    c.id = MP7100Protocol::CmdSetOnOff;
+    c.size = MP7100Protocol::encode(c.id, &off, c.cmd);
+    c.retries = 0;
+    c.done = done;
+    c.user = true;
+    c.postNs = 0;
+    c.step = -1;
+    c.control = false;
+    c.switchOn = false;
+    c.writeNs = 0;
+    m_queue.insert(first, c);
+    if (m_phase == Idle)
+        startNextCommand();
 }
 
-void MP7100::timerEvent(QTimerEvent *event)
+void MP7100::startNextCommand()
 {
-    if (m_idTimer == event->timerId()) {
-        killTimer(m_idTimer);
-        m_idTimer = 0;
-        decodeCommand(QByteArray(), true);
+    if (m_queue.isEmpty()) {
+        m_phase = Idle;
+        return;
     }
+    COMMAND &c = m_queue.head();
+    m_command = c.id;
+    m_phase = (MP7100Protocol::commands[c.id].fields > 0) ? Data : Final;
+    // set commands have no data line to be validated
+    m_valid = true;
+    sendData(c.cmd, c.size);
+    m_txTime.start();
+    if (c.retries == 0)
+        c.writeNs = m_clock.nsecsElapsed();
+    if (c.control && (c.retries == 0)) {
+        QMutexLocker lock(&m_regulatorLock);
+        m_regulator.sent(c.postNs, m_clock.nsecsElapsed());
+    } else if (c.user && (c.postNs > 0) && (c.retries == 0)) {
+        const qint64 nowNs = m_clock.nsecsElapsed();
+        // steps of a sequence report their jitter instead
+        if (c.step < 0) {
+            emit commandSent(c.id, (nowNs - c.postNs)/1e6);
+        } else if (m_sequencer.isRunning()) {
+            const int step = c.step;
+            const bool last = m_sequencer.sent(step, c.postNs, nowNs);
+            emit sequenceProgress(step, m_sequencer.count(), m_sequencer.jitterMs());
+            if (last)
+                finishSequence(false);
+        }
+    }
+    // start a new timeout, doubled for every retransmission
+    double timeoutMs;
+    {
+        QMutexLocker lock(&m_rttLock);
+        timeoutMs = m_rtt[c.id].timeoutMs;
+    }
+    for (int n = 0; n < c.retries; ++n)
+        timeoutMs *= 2.;
+    m_idTimer = startTimer(static_cast<int>(qMin<double>(timeoutMs, COMMAND_TIMEOUT_MS) + 0.999), Qt::PreciseTimer);
 }
 
+void MP7100::commandTimeout()
+{
+    if (m_queue.isEmpty())
+        return;
+    COMMAND &c = m_queue.head();
+    if (m_phase == Resync) {
+        // the line is quiet, the reply of the first attempt is either lost or
+        // has been dropped completely
+        clearInput();
+        startNextCommand();
+    } else if (c.retries < MAX_RETRIES) {
+        // a lost reply costs one timeout and the quiet time only, send the
+        // command again as soon as no late reply is received any more
+        c.retries++;
+        {
+            QMutexLocker lock(&m_rttLock);
+            m_rtt[c.id].retries++;
+        }
+        TCLOG_DEBUG(lcProtocol, "timeout, retrying %1", MP7100Protocol::commands[c.id].mnemonic);
+        m_phase = Resync;
+        m_idTimer = startTimer(static_cast<int>(QUIET_CHARS*charMs() + 0.999), Qt::PreciseTimer);
+    } else {
+        {
+            QMutexLocker lock(&m_rttLock);
+            m_rtt[c.id].timeouts++;
+        }
+        decodeCommand(nullptr, 0, true);
+    }
+}
 
-bool MP7100::sendCommand(const QByteArray &cmd, STATE currentState, STATE newState)
+void MP7100::finishCommand(bool ok)
 {
-//    qDebug() << "+++ MP7100::sendCommand(cmd =" << cmd << "currentState =" << currentState << "newState =" << newState << ") +++";
-//    qDebug() << "      m_state =" << m_state;
-    QMutexLocker lock(&m_lock);
-    if (m_idTimer!=0) {
-        // stop current timeout
+    if (m_idTimer != 0) {
         killTimer(m_idTimer);
         m_idTimer = 0;
     }
-    if (m_state!=currentState) {
-        // create a timeout for any running command
-        decodeCommand(QByteArray(), true);
+    m_phase = Idle;
+    if (m_queue.isEmpty())
+        return;
+    COMMAND c = m_queue.dequeue();
+    // retransmitted commands can't be measured reliably (Karn's algorithm)
+    if (ok && (c.retries == 0))
+        updateRtt(c.id, m_txTime.nsecsElapsed());
+    if (c.done) {
+        m_doneWriteNs = c.writeNs;
+        m_doneRetries = c.retries;
+        REPLY reply;
+        reply.u = voltage();
+        reply.i = current();
+        reply.on = m_On;
+        reply.cc = m_CC;
+        reply.ok = ok;
+        c.done(reply);
     }
-    m_state = newState;
-    QByteArray txData(cmd);
-    if (txData.right(1) != "\r")
-        txData.append('\r');
-    sendData(txData);
-    // start a new timeout
-    m_idTimer = startTimer(1000);
-
-//    qDebug() << "--- MP7100::sendCommand() -> " << true << "---";
-    return true;
+    if (ok && c.switchOn)
+        emit outputSwitchedOn();
+    // the callback may already have started the next command
+    if (m_phase == Idle)
+        startNextCommand();
 }
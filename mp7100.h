@@ -14,23 +14,103 @@
 #define MP7100_H
 
 #include <QObject>
-#include "serdev.h"
+#include <QQueue>
+#include <QAtomicInt>
 #include <QMutex>
+#include <QElapsedTimer>
+#include <functional>
+#include "serdev.h"
+#include "mp7100protocol.h"
+#include "tspscqueue.h"
+#include "triggerengine.h"
+#include "sequencer.h"
+#include "regulator.h"
 
 class MP7100 : public SerDev
 {
     Q_OBJECT
 public:
-    explicit MP7100(QObject *parent = nullptr);
+    explicit MP7100(const QString &portName, QObject *parent = nullptr, const MP7100Protocol::MODEL &model = MP7100Protocol::models[0]);
+
+    // result of a single command, passed to the completion callback
+    typedef struct {
+        double  u;
+        double  i;
+        bool    on;
+        bool    cc;
+        bool    ok;
+    } REPLY;
+    typedef std::function<void(const REPLY &reply)> Callback;
+
+    // measured output values, delivered through takeSample()
+    typedef struct {
+        qint64  t;              // host monotonic time of the reply in ns, see elapsedNs()
+        double  u;
+        double  i;
+        bool    cc;
+        bool    ok;
+    } SAMPLE;
+
+    // consumer side of the sample queue, see samplesAvailable()
+    bool takeSample(SAMPLE &sample);
+    // monotonic time base of the sample timestamps, may be called from any thread
+    qint64 elapsedNs() const { return m_clock.nsecsElapsed(); }
+
+    // round trip statistics of a command, used to derive its timeout
+    typedef struct {
+        double  srttMs;         // smoothed round trip time
+        double  rttvarMs;       // round trip time variation
+        double  lastMs;         // last measured round trip time
+        double  timeoutMs;      // current timeout
+        quint32 samples;        // number of measured round trips
+        quint32 retries;        // number of retransmissions after a timeout
+        quint32 timeouts;       // number of failed commands
+    } RTT_STATS;
+
+    // may be called from any thread
+    RTT_STATS rttStats(MP7100Protocol::COMMAND_ID id) const;
+
+    // triggers are evaluated in the device thread on every measured sample,
+    // may be called from any thread
+    void armTrigger(const TriggerEngine::TRIGGER &trigger);
+    void disarmTrigger(int id);
+    // fast-trip protection: the output is switched off as soon as a measured
+    // sample exceeds maxI or maxP (0 disables a limit). SOUT0 preempts all
+    // queued commands and is sent right after the command in flight.
+    // May be called from any thread.
+    void setProtection(double maxI, double maxP);
+    // run a compiled sequence in the device thread, the steps are issued
+    // ahead of time by the measured command latency. A running sequence is
+    // replaced, switching the output off by protection or trigger aborts it.
+    // May be called from any thread.
+    void startSequence(const QVector<Sequencer::STEP> &steps);
+    void stopSequence();
+    // closed loop regulation on every measured sample while the output is
+    // on, switching the output off by protection or trigger stops it.
+    // May be called from any thread.
+    void setRegulation(const Regulator::CONFIG &config);
+    Regulator::STATS regulationStats() const;
 
 public slots:
-    bool setOnOff(bool on);
-    bool getOnOff();
-    bool setVoltageCurrent(double u, double i);
-    bool getDisplayVoltageCurrent();
-    bool getSetVoltageCurrent();
-    bool getMinimumVoltageCurrent();
-    bool getMaximumVoltageCurrent();
+    // all commands are queued and sent one after the other; the optional
+    // callback is invoked when the command has finished or timed out.
+    // These user commands are sent before the queued polling commands, a
+    // queued SETD is replaced by a newer one.
+    // The device may live in its own thread: commands may then be issued from
+    // exactly one other thread and the callback runs in the device thread.
+    bool setOnOff(bool on, const MP7100::Callback &done = MP7100::Callback());
+    bool getOnOff(const MP7100::Callback &done = MP7100::Callback());
+    bool setVoltageCurrent(double u, double i, const MP7100::Callback &done = MP7100::Callback());
+    bool getDisplayVoltageCurrent(const MP7100::Callback &done = MP7100::Callback());
+    bool getSetVoltageCurrent(const MP7100::Callback &done = MP7100::Callback());
+    bool getMinimumVoltageCurrent(const MP7100::Callback &done = MP7100::Callback());
+    bool getMaximumVoltageCurrent(const MP7100::Callback &done = MP7100::Callback());
+    // poll on/off state, display and set values every intervalMs, 0 stops
+    void setPolling(int intervalMs);
+    // acquisition mode: send the next GETD as soon as the previous one has
+    // finished, on/off state and set values are only read every slowIntervalMs.
+    // Switching it off stops polling as well, use setPolling() to restart it.
+    void setAcquisition(bool on, int slowIntervalMs = 1000);
 
 signals:
     void onoffSet(bool ok);
@@ -40,36 +120,138 @@ signals:
     void setVoltageCurrentGet(double u, double i, bool ok);
     void minimumVoltageCurrentGet(double u, double i, bool ok);
     void maximumVoltageCurrentGet(double u, double i, bool ok);
+    // new samples have been queued after the sample queue was drained
+    void samplesAvailable();
+    // a trigger has fired on the sample received at tNs (see elapsedNs()),
+    // ActionOutputOff has already been sent
+    void triggerFired(int id, int actions, qint64 tNs);
+    // the protection has switched the output off after measuring u and i;
+    // latencies from the reception of the sample to the first write of SOUT0
+    // and to its final OK, ok is false if SOUT0 had to be retransmitted
+    void protectionTripped(double u, double i, double writeMs, double ackMs, bool ok);
+    // a user command has been written latencyMs after it was issued, not
+    // emitted for steps of a sequence and set values of the regulation
+    void commandSent(int id, double latencyMs);
+    // step of a sequence has been written jitterMs after its due time
+    void sequenceProgress(int step, int count, double jitterMs);
+    void sequenceFinished(int sent, int skipped, double meanMs, double maxAbsMs, double stddevMs, bool aborted);
+    // the regulation has been switched off by the protection or a trigger
+    void regulationStopped();
+    // SOUT1 has been acknowledged, by the user, a sequence or any other caller
+    void outputSwitchedOn();
 
 protected:
-    void decodeBuffer(QByteArray &buffer) override;
-    void decodeCommand(const QByteArray &buffer, bool timeout);
+    void decodeBuffer(const char *data, int size) override;
+    void decodeCommand(const char *data, int size, bool timeout);
     void timerEvent(QTimerEvent *event) override;
 
 private:
+    typedef MP7100Protocol::COMMAND_ID COMMAND_ID;
+
     typedef enum {
         Idle,
-        SetOnOff,
-        GetOnOff,
-        GetOnOffFinal,
-        SetVoltageCurrent,
-        GetDisplayVoltageCurrent,
-        GetDisplayVoltageCurrentFinal,
-        GetSetVoltageCurrent,
-        GetSetVoltageCurrentFinal,
-        GetMinimumVoltageCurrent,
-        GetMinimumVoltageCurrentFinal,
-        GetMaximumVoltageCurrent,
-        GetMaximumVoltageCurrentFinal
-    } STATE;
-
-    bool sendCommand(const QByteArray &cmd, STATE currentState, STATE newState);
-
-    QMutex      m_lock;
-    STATE       m_state;
-    double      m_U, m_I;
+        Data,       // waiting for the data line
+        Final,      // waiting for the final "OK"
+        Resync      // timed out, waiting for the line to be quiet
+    } PHASE;
+
+    typedef struct {
+        COMMAND_ID  id;
+        char        cmd[MP7100Protocol::MAX_COMMAND_SIZE];
+        int         size;
+        int         retries;
+        Callback    done;
+        bool        user;       // user command, sent before polling commands
+        qint64      postNs;     // time the user command was issued, see elapsedNs()
+        int         step;       // step of the sequence or -1
+        bool        control;    // set value of the regulation
+        bool        switchOn;   // SOUT1
+        qint64      writeNs;    // first transmission, see elapsedNs()
+    } COMMAND;
+
+    // command request passed from the caller's thread to the device thread
+    typedef struct {
+        COMMAND_ID  id;
+        quint32     args[2];
+        Callback    done;
+        qint64      postNs;
+    } REQUEST;
+
+    // emits the result signal of a command, one entry per command table row
+    typedef void (*RESULT_HANDLER)(MP7100 *dev, bool ok);
+    static const RESULT_HANDLER s_resultHandlers[MP7100Protocol::CommandCount];
+
+    enum { REQUEST_QUEUE_SIZE = 64, SAMPLE_QUEUE_SIZE = 1024 };
+
+    bool postRequest(COMMAND_ID id, const Callback &done, quint32 arg0 = 0, quint32 arg1 = 0);
+    bool sendCommand(COMMAND_ID id, const quint32 *args, const Callback &done, bool user = false, qint64 postNs = 0, int step = -1, bool control = false);
+    void sendOutputOff(const Callback &done);
+    void startNextCommand();
+    void finishCommand(bool ok);
+    void commandTimeout();
+    void updateRtt(COMMAND_ID id, qint64 rttNs);
+    // called for every GETD reply before its result signal is emitted
+    void processSample(bool ok);
+    void pushSample(bool ok);
+    void evaluateTriggers();
+    void checkProtection();
+    void runSequence();
+    void finishSequence(bool aborted);
+    void dropSequenceCommands();
+    void regulate();
+    void poll();
+    void acquire();
+    bool decodeValues(const char *data, int size, int count);
+    quint32 toVoltage(double u) const;
+    quint32 toCurrent(double i) const;
+    // time of one character on the wire: start bit, 8 data bits, stop bit
+    double charMs() const { return 10000./baudrate(); }
+    double voltage() const { return static_cast<double>(m_U)/m_model.voltageScale; }
+    double current() const { return static_cast<double>(m_I)/m_model.currentScale; }
+
+    // the result signals differ in their arguments, pick them by signature
+    void emitResult(void (MP7100::*signal)(bool), bool ok);
+    void emitResult(void (MP7100::*signal)(bool, bool), bool ok);
+    void emitResult(void (MP7100::*signal)(double, double, bool), bool ok);
+    void emitResult(void (MP7100::*signal)(double, double, bool, bool), bool ok);
+
+private slots:
+    void processRequests();
+
+private:
+    const MP7100Protocol::MODEL             m_model;
+    TSpscQueue<REQUEST, REQUEST_QUEUE_SIZE> m_requests;
+    TSpscQueue<SAMPLE, SAMPLE_QUEUE_SIZE>   m_samples;
+    QAtomicInt      m_requestsNotified;
+    QAtomicInt      m_samplesNotified;
+    QQueue<COMMAND> m_queue;    // head is the command currently in flight
+    COMMAND_ID  m_command;      // command in flight
+    PHASE       m_phase;
+    quint32     m_U, m_I;       // last decoded values in model units
     bool        m_On, m_CC;
+    bool        m_valid;        // data line of the current command decoded successfully
     int         m_idTimer;
+    QElapsedTimer   m_txTime;   // time since the command in flight was sent
+    RTT_STATS   m_rtt[MP7100Protocol::CommandCount];
+    mutable QMutex  m_rttLock;
+    int         m_idPollTimer;
+    int         m_pollPending;
+    QElapsedTimer   m_clock;    // time base of the sample timestamps
+    qint64      m_rxTimeNs;     // reception time of the last data line
+    qint64      m_doneWriteNs;  // first transmission of the command whose callback runs
+    int         m_doneRetries;  // and its retransmissions
+    bool        m_acquiring;
+    bool        m_acquirePending;
+    TriggerEngine   m_triggers;
+    QVector<TriggerEngine::FIRED> m_fired;
+    quint32     m_tripI;        // protection limits in model units, 0 = off
+    quint64     m_tripP;        // voltage*current in model units
+    bool        m_tripped;      // output switched off by the protection, until switched on again
+    Sequencer   m_sequencer;
+    int         m_idSequenceTimer;
+    Regulator   m_regulator;
+    quint32     m_regulatedU;   // last set voltage sent by the regulation, model units
+    mutable QMutex  m_regulatorLock;
 };
 
 #endif // MP7100_H
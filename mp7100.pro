@@ -2,7 +2,7 @@ QT       += core gui serialport svg
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++11
+CONFIG += c++17
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -22,26 +22,37 @@ DEFINES += APP_ORGANIZATION=\\\"$$QMAKE_TARGET_COMPANY\\\"
 DEFINES += APP_NAME=\\\"$$QMAKE_TARGET_PRODUCT\\\"
 DEFINES += APP_DOMAIN=\\\"t2ft.de\\\"
 
+include(mp7100device.pri)
+
 SOURCES += \
-    mp7100.cpp \
+    capturefile.cpp \
+    energymeter.cpp \
     main.cpp \
     mainwidget.cpp \
     tmainwidget.cpp \
-    tmessagehandler.cpp \
+    tlogmodel.cpp \
     tapp.cpp \
-    serdev.cpp \
-    tpowereventfilter.cpp
+    samplelod.cpp \
+    samplestore.cpp \
+    tpowereventfilter.cpp \
+    trendplot.cpp \
+    windowstats.cpp
 
 HEADERS += \
-    mp7100.h \
+    capturefile.h \
+    energymeter.h \
     mainwidget.h \
     tmainwidget.h \
-    tmessagehandler.h \
+    tlogmodel.h \
     tmsghandler_main.h \
     tapp.h \
+    samplelod.h \
+    samplestore.h \
     silentcall.h \
-    serdev.h \
-    tpowereventfilter.h
+    tpowereventfilter.h \
+    trendplot.h \
+    tracecodec.h \
+    windowstats.h
 
 FORMS += \
     mainwidget.ui
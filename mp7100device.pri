@@ -0,0 +1,25 @@
+# MP7100 device class and everything it depends on, shared by the
+# application and bench/protocol. New dependencies of mp7100.cpp are added
+# here, so the bench projects keep linking.
+
+include($$PWD/tlog.pri)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/logcategories.cpp \
+    $$PWD/mp7100.cpp \
+    $$PWD/regulator.cpp \
+    $$PWD/sequencer.cpp \
+    $$PWD/serdev.cpp \
+    $$PWD/triggerengine.cpp
+
+HEADERS += \
+    $$PWD/logcategories.h \
+    $$PWD/mp7100.h \
+    $$PWD/mp7100protocol.h \
+    $$PWD/regulator.h \
+    $$PWD/sequencer.h \
+    $$PWD/serdev.h \
+    $$PWD/triggerengine.h \
+    $$PWD/tspscqueue.h
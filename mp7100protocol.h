@@ -0,0 +1,150 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// mp7100protocol.h
+// MP7100 command table and allocation free encoder / decoder helpers
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#ifndef MP7100PROTOCOL_H
+#define MP7100PROTOCOL_H
+
+#include <QtGlobal>
+
+// Every command of the protocol is one row of this table:
+//   id          command identifier, MP7100Protocol::Cmd<id>
+//   mnemonic    command string sent to the device
+//   args        number of numeric arguments appended to the mnemonic
+//   digits      zero padded digits of every argument
+//   fields      number of ';' separated fields of the data line sent before
+//               the final "OK", 0 if the device replies with "OK" only
+//   result      MP7100 signal emitting the result
+#define MP7100_COMMANDS(X) \
+    /* id                        mnemonic args digits fields result                   */ \
+    X(SetOnOff,                  "SOUT",  1,   1,     0,     onoffSet)                   \
+    X(GetOnOff,                  "GOUT",  0,   0,     1,     onoffGet)                   \
+    X(SetVoltageCurrent,         "SETD",  2,   4,     0,     voltageCurrentSet)          \
+    X(GetDisplayVoltageCurrent,  "GETD",  0,   0,     3,     displayVoltageCurrentGet)   \
+    X(GetSetVoltageCurrent,      "GETS",  0,   0,     2,     setVoltageCurrentGet)       \
+    X(GetMinimumVoltageCurrent,  "GMIN",  0,   0,     2,     minimumVoltageCurrentGet)   \
+    X(GetMaximumVoltageCurrent,  "GMAX",  0,   0,     2,     maximumVoltageCurrentGet)
+
+class MP7100Protocol
+{
+public:
+#define MP7100_COMMAND_ID(id, mnemonic, args, digits, fields, result) Cmd##id,
+    typedef enum {
+        MP7100_COMMANDS(MP7100_COMMAND_ID)
+        CommandCount
+    } COMMAND_ID;
+#undef MP7100_COMMAND_ID
+
+    typedef struct {
+        const char  *mnemonic;
+        int         args;
+        int         digits;
+        int         fields;
+    } COMMAND_DESC;
+
+#define MP7100_COMMAND_DESC(id, mnemonic, args, digits, fields, result) { mnemonic, args, digits, fields },
+    static constexpr COMMAND_DESC commands[CommandCount] = {
+        MP7100_COMMANDS(MP7100_COMMAND_DESC)
+    };
+#undef MP7100_COMMAND_DESC
+
+    // fixed-point scaling of voltage and current of a supply model
+    typedef struct {
+        const char  *name;
+        quint32     voltageScale;   // counts per volt
+        quint32     currentScale;   // counts per ampere
+    } MODEL;
+
+    static constexpr MODEL models[] = {
+        { "MP7100",  100, 1000 },
+    };
+
+    // maximum size of an encoded command including the terminator
+    enum { MAX_COMMAND_SIZE = 16 };
+
+    // Encode command id with its arguments into out, which must provide
+    // MAX_COMMAND_SIZE bytes. Returns the number of bytes written.
+    static int encode(COMMAND_ID id, const quint32 *args, char *out)
+    {
+        const COMMAND_DESC &desc = commands[id];
+        int n = 0;
+        for (const char *m = desc.mnemonic; *m; ++m)
+            out[n++] = *m;
+        for (int a = 0; a < desc.args; ++a) {
+            quint32 max = 1;
+            for (int d = 0; d < desc.digits; ++d)
+                max *= 10;
+            quint32 v = qMin(args[a], max-1);
+            for (int d = desc.digits-1; d >= 0; --d) {
+                out[n+d] = static_cast<char>('0' + v%10);
+                v /= 10;
+            }
+            n += desc.digits;
+        }
+        out[n++] = '\r';
+        return n;
+    }
+
+    // Find the command a received line starts with, returns CommandCount if
+    // the line doesn't start with a known mnemonic.
+    static COMMAND_ID identify(const char *data, int size)
+    {
+        for (int id = 0; id < CommandCount; ++id) {
+            const char *m = commands[id].mnemonic;
+            int n = 0;
+            while (m[n] && (n < size) && (m[n] == data[n]))
+                ++n;
+            if (m[n] == 0)
+                return static_cast<COMMAND_ID>(id);
+        }
+        return CommandCount;
+    }
+
+    // maximum number of digits of a single reply field
+    enum { MAX_FIELD_DIGITS = 9 };
+
+    // Decode a reply line of exactly count decimal fields separated by ';'
+    // (e.g. "UUUU;IIII;C") into values. Every field must consist of 1 to
+    // MAX_FIELD_DIGITS digits, nothing else is accepted. values is only
+    // valid if true is returned.
+    static bool parseFields(const char *data, int size, quint32 *values, int count)
+    {
+        const char *p = data;
+        const char * const end = data + size;
+        for (int n = 0; n < count; ++n) {
+            if (n > 0) {
+                if ((p == end) || (*p != ';'))
+                    return false;
+                ++p;
+            }
+            quint32 v = 0;
+            const char * const start = p;
+            while ((p != end) && (*p >= '0') && (*p <= '9')) {
+                if (p - start >= MAX_FIELD_DIGITS)
+                    return false;
+                v = v*10 + static_cast<quint32>(*p - '0');
+                ++p;
+            }
+            if (p == start)
+                return false;
+            values[n] = v;
+        }
+        return p == end;
+    }
+
+    // the final line of every command
+    static bool isOk(const char *data, int size)
+    {
+        return (size >= 2) && (data[0] == 'O') && (data[1] == 'K');
+    }
+};
+
+#endif // MP7100PROTOCOL_H
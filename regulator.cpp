@@ -0,0 +1,111 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// regulator.cpp
+// closed loop constant power and constant resistance regulation
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "regulator.h"
+#include <cmath>
+
+// samples further apart restart the loop from the present set voltage
+#define MAX_GAP_MS      2000
+// lower limit of the current used to scale the power error
+#define MIN_CURRENT     0.01
+
+Regulator::Regulator()
+    : m_started(false)
+    , m_lastNs(0)
+    , m_integral(0.)
+    , m_out(0.)
+{
+    m_config.mode = Off;
+    m_config.target = 0.;
+    m_config.resistance = 0.;
+    m_config.currentLimit = 0.;
+    m_config.maxVoltage = 0.;
+    m_config.kp = 0.;
+    m_config.ki = 0.;
+    m_config.maxRate = 0.;
+    configure(m_config, 0.);
+}
+
+void Regulator::configure(const CONFIG &config, double u)
+{
+    m_config = config;
+    m_started = false;
+    // bumpless start from the present set voltage
+    m_out = qBound(0., u, qMax(0., m_config.maxVoltage));
+    m_integral = m_out;
+    m_stats.updates = 0;
+    m_stats.commands = 0;
+    m_stats.limited = 0;
+    m_stats.intervalMs = 0.;
+    m_stats.intervalStddevMs = 0.;
+    m_stats.maxIntervalMs = 0.;
+    m_stats.latencyMs = 0.;
+    m_stats.maxLatencyMs = 0.;
+    m_sumIntervalMs = 0.;
+    m_sumSqIntervalMs = 0.;
+    m_sumLatencyMs = 0.;
+}
+
+bool Regulator::update(qint64 tNs, double u, double i, double &setU)
+{
+    if (!isActive())
+        return false;
+    if (!m_started || (tNs <= m_lastNs) || (tNs - m_lastNs > static_cast<qint64>(MAX_GAP_MS)*1000000)) {
+        // the first sample only provides the time base
+        m_started = true;
+        m_lastNs = tNs;
+        m_integral = m_out;
+        return false;
+    }
+    const double intervalMs = (tNs - m_lastNs)/1e6;
+    const double dt = intervalMs/1000.;
+    m_lastNs = tNs;
+    const quint32 n = ++m_stats.updates;
+    m_sumIntervalMs += intervalMs;
+    m_sumSqIntervalMs += intervalMs*intervalMs;
+    m_stats.intervalMs = m_sumIntervalMs/n;
+    m_stats.intervalStddevMs = (n > 1) ? std::sqrt(qMax(0., (m_sumSqIntervalMs - m_sumIntervalMs*m_sumIntervalMs/n)/(n - 1))) : 0.;
+    m_stats.maxIntervalMs = qMax(m_stats.maxIntervalMs, intervalMs);
+
+    // control error in volts
+    double e;
+    if (m_config.mode == ConstantPower)
+        e = (m_config.target - u*i)/qMax(i, MIN_CURRENT);
+    else
+        e = m_config.target - m_config.resistance*i - u;
+    const double integral = m_integral + m_config.ki*e*dt;
+    const double out = integral + m_config.kp*e;
+    // output range and slope
+    const double step = m_config.maxRate*dt;
+    double limited = qBound(0., out, m_config.maxVoltage);
+    limited = qBound(m_out - step, limited, m_out + step);
+    if (limited != out) {
+        m_stats.limited++;
+        // anti-windup: only integrate back towards the limited output
+        if (((out > limited) && (e < 0.)) || ((out < limited) && (e > 0.)))
+            m_integral = integral;
+    } else {
+        m_integral = integral;
+    }
+    m_out = limited;
+    setU = m_out;
+    return true;
+}
+
+void Regulator::sent(qint64 sampleNs, qint64 nowNs)
+{
+    const double latencyMs = (nowNs - sampleNs)/1e6;
+    m_sumLatencyMs += latencyMs;
+    m_stats.commands++;
+    m_stats.latencyMs = m_sumLatencyMs/m_stats.commands;
+    m_stats.maxLatencyMs = qMax(m_stats.maxLatencyMs, latencyMs);
+}
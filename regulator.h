@@ -0,0 +1,85 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// regulator.h
+// closed loop constant power and constant resistance regulation, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// The device only regulates voltage and current. A PI controller run by
+// MP7100 on every measured sample adjusts the set voltage instead:
+//   ConstantPower       U*I = target, the set voltage is limited to maxVoltage
+//   ConstantResistance  U = target - resistance*I, i.e. a source with an
+//                       internal resistance
+// The power error is scaled to volts by the measured current, so the gains
+// have the same meaning in both modes. The integrator is frozen while the
+// output is limited (anti-windup), the output slope is limited to maxRate.
+// ***************************************************************************
+#ifndef REGULATOR_H
+#define REGULATOR_H
+
+#include <QtGlobal>
+
+class Regulator
+{
+public:
+    typedef enum {
+        Off,
+        ConstantPower,
+        ConstantResistance
+    } MODE;
+
+    typedef struct {
+        MODE        mode;
+        double      target;         // W (ConstantPower) or open circuit V (ConstantResistance)
+        double      resistance;     // Ohm, ConstantResistance only
+        double      currentLimit;   // A, sent with every SETD
+        double      maxVoltage;     // V, upper limit of the set voltage
+        double      kp;             // V/V
+        double      ki;             // V/(V*s)
+        double      maxRate;        // V/s
+    } CONFIG;
+
+    // loop timing, the control bandwidth is limited by the update interval
+    // plus the latency from the sample to the new set value on the wire
+    typedef struct {
+        quint32     updates;        // samples processed
+        quint32     commands;       // set values written
+        quint32     limited;        // updates with a limited output
+        double      intervalMs;     // mean sample interval
+        double      intervalStddevMs;
+        double      maxIntervalMs;
+        double      latencyMs;      // mean time sample received -> SETD written
+        double      maxLatencyMs;
+    } STATS;
+
+    Regulator();
+
+    // u is the present set voltage, regulation starts from there
+    void configure(const CONFIG &config, double u);
+    bool isActive() const { return m_config.mode != Off; }
+    const CONFIG &config() const { return m_config; }
+
+    // feed a measured sample, returns true if a new set voltage must be sent
+    bool update(qint64 tNs, double u, double i, double &setU);
+    // the set value calculated from the sample at sampleNs has been written at nowNs
+    void sent(qint64 sampleNs, qint64 nowNs);
+
+    const STATS &stats() const { return m_stats; }
+
+private:
+    CONFIG      m_config;
+    bool        m_started;      // m_lastNs is valid
+    qint64      m_lastNs;
+    double      m_integral;
+    double      m_out;          // last set voltage
+    STATS       m_stats;
+    double      m_sumIntervalMs, m_sumSqIntervalMs;
+    double      m_sumLatencyMs;
+};
+
+#endif // REGULATOR_H
@@ -0,0 +1,123 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplelod.cpp
+// min/max level of detail pyramid of a sample store
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "samplelod.h"
+
+SampleLod::SampleLod(const SampleStore &store)
+    : m_store(store)
+    , m_levels(1)
+    , m_partial(empty())
+    , m_end(0)
+{
+    while (bucketSize(m_levels) <= static_cast<quint64>(m_store.capacity()))
+        m_levels++;
+    m_buckets.resize(m_levels);
+    for (int level = 0; level < m_levels; ++level) {
+        // one extra bucket: the oldest one may still be partly held by the store
+        m_buckets[level].resize(static_cast<int>(m_store.capacity()/bucketSize(level)) + 1);
+    }
+    reset(0);
+}
+
+void SampleLod::reset(quint64 begin)
+{
+    for (auto &level : m_buckets)
+        level.fill(empty());
+    m_partial = empty();
+    m_end = begin;
+}
+
+void SampleLod::merge(MINMAX &a, const MINMAX &b)
+{
+    a.uMin = qMin(a.uMin, b.uMin);
+    a.uMax = qMax(a.uMax, b.uMax);
+    a.iMin = qMin(a.iMin, b.iMin);
+    a.iMax = qMax(a.iMax, b.iMax);
+}
+
+void SampleLod::mergeSample(MINMAX &a, quint64 n) const
+{
+    const quint16 u = m_store.rawVoltage(n);
+    const quint16 i = m_store.rawCurrent(n);
+    a.uMin = qMin(a.uMin, u);
+    a.uMax = qMax(a.uMax, u);
+    a.iMin = qMin(a.iMin, i);
+    a.iMax = qMax(a.iMax, i);
+}
+
+void SampleLod::update()
+{
+    const SampleStore::RANGE all = m_store.all();
+    // the store has been cleared or overwrote samples not processed yet
+    if ((all.end < m_end) || (all.begin > m_end))
+        reset(all.begin);
+    for (quint64 n = m_end; n < all.end; ++n) {
+        mergeSample(m_partial, n);
+        if (((n + 1) % BASE_SIZE) != 0)
+            continue;
+        // level 0 bucket complete, combine upwards as long as a parent completes
+        quint64 k = n/BASE_SIZE;
+        bucket(0, k) = m_partial;
+        m_partial = empty();
+        for (int level = 0; (level + 1 < m_levels) && (((k + 1) % FANOUT) == 0); ++level) {
+            k /= FANOUT;
+            MINMAX m = empty();
+            for (quint64 c = k*FANOUT; c < (k + 1)*FANOUT; ++c)
+                merge(m, bucket(level, c));
+            bucket(level + 1, k) = m;
+        }
+    }
+    m_end = all.end;
+}
+
+void SampleLod::mergeBuckets(MINMAX &a, int level, quint64 begin, quint64 end) const
+{
+    const quint64 size = bucketSize(level);
+    for (quint64 k = begin/size; k < end/size; ++k)
+        merge(a, bucket(level, k));
+}
+
+SampleLod::MINMAX SampleLod::aggregate(quint64 begin, quint64 end) const
+{
+    MINMAX m = empty();
+    end = qMin(end, m_end);
+    if (begin >= end)
+        return m;
+    // samples outside of complete level 0 buckets are read directly
+    const quint64 base = BASE_SIZE;
+    quint64 a = qMin((begin + base - 1)/base*base, end);
+    quint64 b = qMax(end/base*base, a);
+    for (quint64 n = begin; n < a; ++n)
+        mergeSample(m, n);
+    for (quint64 n = b; n < end; ++n)
+        mergeSample(m, n);
+    // climb up while the next level has complete buckets inside [a, b)
+    int level = 0;
+    while (a < b) {
+        if (level + 1 < m_levels) {
+            const quint64 size = bucketSize(level + 1);
+            const quint64 a1 = (a + size - 1)/size*size;
+            const quint64 b1 = b/size*size;
+            if (a1 < b1) {
+                mergeBuckets(m, level, a, a1);
+                mergeBuckets(m, level, b1, b);
+                a = a1;
+                b = b1;
+                level++;
+                continue;
+            }
+        }
+        mergeBuckets(m, level, a, b);
+        break;
+    }
+    return m;
+}
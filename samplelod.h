@@ -0,0 +1,59 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplelod.h
+// min/max level of detail pyramid of a sample store, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Level 0 keeps minimum and maximum of voltage and current of every
+// BASE_SIZE samples, every further level combines FANOUT buckets of the
+// level below. The minimum and maximum of any sample range is then found
+// from a few buckets per level, independent of the length of the range.
+// ***************************************************************************
+#ifndef SAMPLELOD_H
+#define SAMPLELOD_H
+
+#include <QVector>
+#include "samplestore.h"
+
+class SampleLod
+{
+public:
+    enum { BASE_SIZE = 16, FANOUT_BITS = 2, FANOUT = 1 << FANOUT_BITS };
+
+    typedef struct {
+        quint16 uMin, uMax;
+        quint16 iMin, iMax;
+    } MINMAX;
+
+    explicit SampleLod(const SampleStore &store);
+
+    // catch up with the samples appended to the store since the last call
+    void update();
+    // minimum and maximum of the samples [begin, end) in model units
+    MINMAX aggregate(quint64 begin, quint64 end) const;
+    static bool isEmpty(const MINMAX &m) { return m.uMin > m.uMax; }
+
+private:
+    static MINMAX empty() { return { 0xffff, 0, 0xffff, 0 }; }
+    static void merge(MINMAX &a, const MINMAX &b);
+    void mergeSample(MINMAX &a, quint64 n) const;
+    void reset(quint64 begin);
+    quint64 bucketSize(int level) const { return static_cast<quint64>(BASE_SIZE) << (FANOUT_BITS*level); }
+    MINMAX &bucket(int level, quint64 k) { QVector<MINMAX> &b = m_buckets[level]; return b[static_cast<int>(k % b.size())]; }
+    const MINMAX &bucket(int level, quint64 k) const { const QVector<MINMAX> &b = m_buckets[level]; return b[static_cast<int>(k % b.size())]; }
+    void mergeBuckets(MINMAX &a, int level, quint64 begin, quint64 end) const;
+
+    const SampleStore   &m_store;
+    int                 m_levels;
+    QVector<QVector<MINMAX>> m_buckets; // per level, ring covering the store capacity
+    MINMAX              m_partial;      // level 0 bucket being filled
+    quint64             m_end;          // absolute index of the next sample to process
+};
+
+#endif // SAMPLELOD_H
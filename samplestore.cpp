@@ -0,0 +1,98 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplestore.cpp
+// columnar in-memory history of the measured values
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "samplestore.h"
+
+SampleStore::SampleStore(int capacity, const MP7100Protocol::MODEL &model)
+    : m_model(model)
+    , m_capacity(32)
+    , m_begin(0)
+    , m_end(0)
+    , m_t0Ns(0)
+{
+    while (m_capacity < capacity)
+        m_capacity <<= 1;
+    m_t.resize(m_capacity);
+    m_u.resize(m_capacity);
+    m_i.resize(m_capacity);
+    m_cc.resize(m_capacity/32);
+}
+
+void SampleStore::append(qint64 tNs, double u, double i, bool cc)
+{
+    if (m_end == 0)
+        m_t0Ns = tNs;
+    // overwrite the oldest sample when full
+    if (m_end - m_begin == static_cast<quint64>(m_capacity))
+        m_begin++;
+    const int p = pos(m_end);
+    const qint64 ms = qMax<qint64>(0, (tNs - m_t0Ns)/1000000);
+    m_t[p] = static_cast<quint32>(qMin<qint64>(ms, 0xffffffff));
+    m_u[p] = static_cast<quint16>(qBound(0., u*m_model.voltageScale + 0.5, 65535.));
+    m_i[p] = static_cast<quint16>(qBound(0., i*m_model.currentScale + 0.5, 65535.));
+    const quint32 bit = 1u << (p & 31);
+    if (cc)
+        m_cc[p >> 5] |= bit;
+    else
+        m_cc[p >> 5] &= ~bit;
+    m_end++;
+}
+
+void SampleStore::clear()
+{
+    m_begin = 0;
+    m_end = 0;
+    m_t0Ns = 0;
+}
+
+quint64 SampleStore::lowerBound(quint32 ms) const
+{
+    // timestamps are monotonic, binary search for the first t >= ms
+    quint64 lo = m_begin;
+    quint64 hi = m_end;
+    while (lo < hi) {
+        const quint64 mid = lo + (hi - lo)/2;
+        if (m_t[pos(mid)] < ms)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+SampleStore::RANGE SampleStore::range(quint32 fromMs, quint32 toMs) const
+{
+    RANGE r;
+    r.begin = lowerBound(fromMs);
+    r.end = qMax(r.begin, lowerBound(toMs));
+    return r;
+}
+
+int SampleStore::segments(const RANGE &r, SEGMENT seg[2]) const
+{
+    const quint64 begin = qMax(r.begin, m_begin);
+    const quint64 end = qMin(r.end, m_end);
+    int n = 0;
+    quint64 first = begin;
+    while (first < end) {
+        const int p = pos(first);
+        const int count = static_cast<int>(qMin<quint64>(end - first, static_cast<quint64>(m_capacity - p)));
+        seg[n].first = first;
+        seg[n].count = count;
+        seg[n].t = m_t.constData() + p;
+        seg[n].u = m_u.constData() + p;
+        seg[n].i = m_i.constData() + p;
+        first += count;
+        n++;
+    }
+    return n;
+}
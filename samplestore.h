@@ -0,0 +1,94 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// samplestore.h
+// columnar in-memory history of the measured values, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// All memory is allocated once. Timestamps, voltage, current and the CC flag
+// are kept in separate arrays of fixed-point values, the oldest samples are
+// overwritten when the store is full. Samples are addressed by their
+// absolute index, which counts all samples ever appended. Not thread safe,
+// the store is owned and used by the GUI thread.
+// ***************************************************************************
+#ifndef SAMPLESTORE_H
+#define SAMPLESTORE_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "mp7100protocol.h"
+
+class SampleStore
+{
+public:
+    // 4M samples = 33 MB: about 2 weeks at 3 samples/s or a day at full
+    // serial link speed
+    enum { DEFAULT_CAPACITY = 1 << 22 };
+
+    // capacity is rounded up to a power of 2
+    explicit SampleStore(int capacity = DEFAULT_CAPACITY, const MP7100Protocol::MODEL &model = MP7100Protocol::models[0]);
+
+    // absolute indices [begin, end) of held samples
+    typedef struct {
+        quint64 begin;
+        quint64 end;
+    } RANGE;
+
+    // contiguous part of a range, the CC flags are read through cc()
+    typedef struct {
+        quint64         first;  // absolute index of t[0]
+        int             count;
+        const quint32   *t;     // ms
+        const quint16   *u;     // model voltage units
+        const quint16   *i;     // model current units
+    } SEGMENT;
+
+    // tNs is a monotonic host time, timestamps are kept in ms relative to the
+    // first sample appended after construction or clear(); O(1)
+    void append(qint64 tNs, double u, double i, bool cc);
+    void clear();
+
+    int capacity() const { return m_capacity; }
+    int size() const { return static_cast<int>(m_end - m_begin); }
+    bool isEmpty() const { return m_end == m_begin; }
+    // all held samples
+    RANGE all() const { return { m_begin, m_end }; }
+    // held samples with fromMs <= t < toMs, O(log n)
+    RANGE range(quint32 fromMs, quint32 toMs) const;
+    // split a range into at most 2 contiguous segments, returns their number
+    int segments(const RANGE &r, SEGMENT seg[2]) const;
+
+    // access to single samples, n must be inside all()
+    quint32 timeMs(quint64 n) const { return m_t[pos(n)]; }
+    double voltage(quint64 n) const { return static_cast<double>(m_u[pos(n)])/m_model.voltageScale; }
+    double current(quint64 n) const { return static_cast<double>(m_i[pos(n)])/m_model.currentScale; }
+    quint16 rawVoltage(quint64 n) const { return m_u[pos(n)]; }
+    quint16 rawCurrent(quint64 n) const { return m_i[pos(n)]; }
+    bool cc(quint64 n) const { const int p = pos(n); return (m_cc[p >> 5] >> (p & 31)) & 1; }
+    // host time tNs in the time base of the store
+    quint32 toMs(qint64 tNs) const { return static_cast<quint32>(qBound<qint64>(0, (tNs - m_t0Ns)/1000000, 0xffffffff)); }
+    // time of the newest sample, 0 if empty
+    quint32 lastTimeMs() const { return isEmpty() ? 0 : timeMs(m_end-1); }
+    const MP7100Protocol::MODEL &model() const { return m_model; }
+
+private:
+    int pos(quint64 n) const { return static_cast<int>(n & static_cast<quint64>(m_capacity-1)); }
+    quint64 lowerBound(quint32 ms) const;
+
+    const MP7100Protocol::MODEL m_model;
+    int                 m_capacity;
+    QVector<quint32>    m_t;
+    QVector<quint16>    m_u;
+    QVector<quint16>    m_i;
+    QVector<quint32>    m_cc;       // one bit per sample
+    quint64             m_begin;    // absolute index of the oldest sample
+    quint64             m_end;      // absolute index of the next sample
+    qint64              m_t0Ns;     // host time of timestamp 0
+};
+
+#endif // SAMPLESTORE_H
@@ -0,0 +1,281 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// sequencer.cpp
+// time accurate setpoint sequences
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "sequencer.h"
+#include <QStringList>
+#include <cmath>
+
+// default step width of ramps
+#define RAMP_STEP_MS    100
+// maximum nesting of repeat blocks
+#define MAX_NESTING     8
+// the time of a step is stored in 32 bits
+#define MAX_TIME_MS     0xffffffffLL
+
+namespace {
+
+// state of the compiler, the table is expanded while parsing
+typedef struct {
+    const MP7100Protocol::MODEL *model;
+    QVector<Sequencer::STEP>    *steps;
+    qint64                      tMs;        // time cursor
+    QString                     error;
+} COMPILER;
+
+bool addStep(COMPILER &c, Sequencer::OP op, double u = 0., double i = 0.)
+{
+    if (c.steps->size() >= Sequencer::MAX_STEPS) {
+        c.error = QString("more than %1 steps").arg(Sequencer::MAX_STEPS);
+        return false;
+    }
+    if (c.tMs > MAX_TIME_MS) {
+        c.error = "sequence too long";
+        return false;
+    }
+    Sequencer::STEP s;
+    s.tMs = static_cast<quint32>(c.tMs);
+    s.u = static_cast<quint16>(qBound(0., u*c.model->voltageScale + 0.5, 65535.));
+    s.i = static_cast<quint16>(qBound(0., i*c.model->currentScale + 0.5, 65535.));
+    s.op = static_cast<quint8>(op);
+    c.steps->append(s);
+    return true;
+}
+
+// counts and times are checked while they are doubles, converting a value
+// out of the range of the integer is undefined
+bool checkCount(COMPILER &c, double count)
+{
+    if (count <= Sequencer::MAX_STEPS)
+        return true;
+    c.error = QString("more than %1 steps").arg(Sequencer::MAX_STEPS);
+    return false;
+}
+
+bool checkTime(COMPILER &c, double ms)
+{
+    if ((ms >= 0.) && (c.tMs + ms <= MAX_TIME_MS))
+        return true;
+    c.error = "sequence too long";
+    return false;
+}
+
+// moves the time cursor by ms
+bool advance(COMPILER &c, double ms)
+{
+    if (!checkTime(c, ms))
+        return false;
+    c.tMs += static_cast<qint64>(ms + 0.5);
+    return true;
+}
+
+// linear ramp from x0 to x1 in ms, with at least one step per stepMs
+bool addRamp(COMPILER &c, bool voltage, double x0, double x1, double other, double ms, double stepMs)
+{
+    const double steps = std::ceil(ms/stepMs);
+    if (!checkTime(c, ms) || !checkCount(c, steps))
+        return false;
+    const int n = qMax(1, static_cast<int>(steps));
+    const qint64 t0 = c.tMs;
+    for (int k = 0; k <= n; ++k) {
+        const double x = x0 + (x1 - x0)*k/n;
+        c.tMs = t0 + static_cast<qint64>(ms*k/n + 0.5);
+        if (!addStep(c, Sequencer::OpSet, voltage ? x : other, voltage ? other : x))
+            return false;
+    }
+    return true;
+}
+
+}
+
+
+bool Sequencer::compile(const QString &profile, const MP7100Protocol::MODEL &model, QVector<STEP> &steps, QString &error)
+{
+    typedef struct {
+        int     line;           // line of the repeat statement
+        int     remaining;      // repetitions after the current one
+        int     firstStep;      // first step of the block
+        qint64  t0Ms;           // time cursor at the start of the block
+    } BLOCK;
+
+    steps.clear();
+    COMPILER c;
+    c.model = &model;
+    c.steps = &steps;
+    c.tMs = 0;
+    QVector<BLOCK> blocks;
+    const QStringList lines = profile.split('\n');
+    for (int l = 0; l < lines.size(); ++l) {
+        QString line = lines.at(l);
+        const int comment = line.indexOf('#');
+        if (comment >= 0)
+            line.truncate(comment);
+        line = line.simplified().toLower();
+        if (line.isEmpty())
+            continue;
+        const QStringList f = line.split(' ');
+        // all arguments are numbers
+        QVector<double> a;
+        bool ok = true;
+        for (int n = 1; ok && (n < f.size()); ++n)
+            a.append(f.at(n).toDouble(&ok));
+        const QString &cmd = f.first();
+        auto args = [&](int min, int max) {
+            if (ok && (a.size() >= min) && (a.size() <= max))
+                return true;
+            c.error = QString("invalid arguments of '%1'").arg(cmd);
+            return false;
+        };
+        bool result = false;
+        if (cmd == "on") {
+            result = args(0, 0) && addStep(c, OpOn);
+        } else if (cmd == "off") {
+            result = args(0, 0) && addStep(c, OpOff);
+        } else if (cmd == "set") {
+            result = args(2, 2) && addStep(c, OpSet, a[0], a[1]);
+        } else if (cmd == "wait") {
+            result = args(1, 1) && (a[0] >= 0.) && advance(c, a[0]);
+        } else if ((cmd == "ramp") || (cmd == "iramp")) {
+            result = args(4, 5) && (a[3] > 0.) && ((a.size() < 5) || (a[4] > 0.))
+                    && addRamp(c, cmd == "ramp", a[0], a[1], a[2], a[3], (a.size() < 5) ? RAMP_STEP_MS : a[4]);
+        } else if (cmd == "stairs") {
+            result = args(5, 5) && (a[2] >= 1.) && checkCount(c, a[2]);
+            const int n = result ? static_cast<int>(a[2]) : 0;
+            for (int k = 0; result && (k < n); ++k) {
+                result = addStep(c, OpSet, (n > 1) ? a[0] + (a[1] - a[0])*k/(n - 1) : a[1], a[3])
+                        && advance(c, a[4]);
+            }
+        } else if (cmd == "pulse") {
+            result = args(6, 6) && (a[5] >= 1.) && checkCount(c, 2.*a[5]);
+            const int n = result ? static_cast<int>(a[5]) : 0;
+            for (int k = 0; result && (k < n); ++k) {
+                result = addStep(c, OpSet, a[0], a[2]) && advance(c, a[3])
+                        && addStep(c, OpSet, a[1], a[2]) && advance(c, a[4]);
+            }
+        } else if (cmd == "repeat") {
+            result = args(1, 1) && (a[0] >= 1.) && (a[0] <= MAX_STEPS) && (blocks.size() < MAX_NESTING);
+            if (result)
+                blocks.append({ l, static_cast<int>(a[0]) - 1, steps.size(), c.tMs });
+        } else if (cmd == "end") {
+            result = args(0, 0) && !blocks.isEmpty();
+            if (result) {
+                // copy the block, shifted by its duration
+                const BLOCK b = blocks.takeLast();
+                const int last = steps.size();
+                const qint64 duration = c.tMs - b.t0Ms;
+                for (int r = 1; result && (r <= b.remaining); ++r) {
+                    for (int n = b.firstStep; result && (n < last); ++n) {
+                        c.tMs = steps.at(n).tMs + r*duration;
+                        result = addStep(c, static_cast<OP>(steps.at(n).op));
+                        if (result) {
+                            steps.last().u = steps.at(n).u;
+                            steps.last().i = steps.at(n).i;
+                        }
+                    }
+                }
+                c.tMs = b.t0Ms + (b.remaining + 1)*duration;
+            }
+        } else {
+            c.error = QString("unknown statement '%1'").arg(cmd);
+        }
+        if (!result) {
+            error = QString("line %1: %2").arg(l + 1).arg(c.error.isEmpty() ? "invalid statement" : c.error);
+            return false;
+        }
+    }
+    if (!blocks.isEmpty()) {
+        error = QString("line %1: repeat without end").arg(blocks.last().line + 1);
+        return false;
+    }
+    if (steps.isEmpty()) {
+        error = "empty sequence";
+        return false;
+    }
+    return true;
+}
+
+
+Sequencer::Sequencer()
+    : m_running(false)
+    , m_startNs(0)
+    , m_next(0)
+    , m_latencyNs(0.)
+    , m_sent(0)
+    , m_skipped(0)
+    , m_sumMs(0.)
+    , m_sumSqMs(0.)
+    , m_maxAbsMs(0.)
+    , m_lastJitterMs(0.)
+{
+}
+
+void Sequencer::start(const QVector<STEP> &steps, qint64 nowNs)
+{
+    m_steps = steps;
+    m_running = !m_steps.isEmpty();
+    m_startNs = nowNs;
+    m_next = 0;
+    m_latencyNs = 0.;
+    m_sent = 0;
+    m_skipped = 0;
+    m_sumMs = m_sumSqMs = m_maxAbsMs = m_lastJitterMs = 0.;
+}
+
+void Sequencer::stop()
+{
+    m_running = false;
+}
+
+qint64 Sequencer::issueNs() const
+{
+    return dueNs(m_next) - static_cast<qint64>(m_latencyNs);
+}
+
+bool Sequencer::sent(int n, qint64 issuedNs, qint64 nowNs)
+{
+    // smoothed like the round trip time, the latency depends on the
+    // commands in flight and varies from step to step
+    const double latencyNs = nowNs - issuedNs;
+    m_latencyNs = (m_sent == 0) ? latencyNs : 0.875*m_latencyNs + 0.125*latencyNs;
+    const double jitterMs = (nowNs - dueNs(n))/1e6;
+    m_sent++;
+    m_sumMs += jitterMs;
+    m_sumSqMs += jitterMs*jitterMs;
+    m_maxAbsMs = qMax(m_maxAbsMs, qAbs(jitterMs));
+    m_lastJitterMs = jitterMs;
+    return done(n);
+}
+
+bool Sequencer::skipped(int n)
+{
+    m_skipped++;
+    return done(n);
+}
+
+bool Sequencer::done(int n)
+{
+    if (n < m_steps.size() - 1)
+        return false;
+    m_running = false;
+    return true;
+}
+
+Sequencer::STATS Sequencer::stats() const
+{
+    STATS s;
+    s.sent = m_sent;
+    s.skipped = m_skipped;
+    s.meanMs = (m_sent > 0) ? m_sumMs/m_sent : 0.;
+    s.maxAbsMs = m_maxAbsMs;
+    s.stddevMs = (m_sent > 1) ? std::sqrt(qMax(0., (m_sumSqMs - m_sumMs*m_sumMs/m_sent)/(m_sent - 1))) : 0.;
+    s.latencyMs = m_latencyNs/1e6;
+    return s;
+}
@@ -0,0 +1,101 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// sequencer.h
+// time accurate setpoint sequences, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// A profile is compiled into a flat table of steps with absolute times, which
+// is run by MP7100 in the device thread against its monotonic clock. Profile
+// syntax, one statement per line, '#' starts a comment, times in ms:
+//   on | off                               switch the output
+//   set <U> <I>                            set voltage and current
+//   wait <ms>
+//   ramp <U0> <U1> <I> <ms> [<stepMs>]     linear voltage ramp, default 100 ms steps
+//   iramp <I0> <I1> <U> <ms> [<stepMs>]    linear current ramp
+//   stairs <U0> <U1> <n> <I> <ms>          n voltage steps of ms each
+//   pulse <Uhigh> <Ulow> <I> <highMs> <lowMs> <count>
+//   repeat <n> ... end                     may be nested
+// ***************************************************************************
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QString>
+#include "mp7100protocol.h"
+
+class Sequencer
+{
+public:
+    enum { MAX_STEPS = 1 << 20 };
+
+    typedef enum {
+        OpSet,
+        OpOn,
+        OpOff
+    } OP;
+
+    // one command of the compiled table, 12 bytes
+    typedef struct {
+        quint32     tMs;        // due time since the start of the sequence
+        quint16     u, i;       // model units, OpSet only
+        quint8      op;         // OP
+    } STEP;
+
+    // schedule accuracy of the steps sent so far
+    typedef struct {
+        int         sent;
+        int         skipped;    // replaced by a newer SETD before they were sent
+        double      meanMs;     // jitter: time sent - time due
+        double      maxAbsMs;
+        double      stddevMs;
+        double      latencyMs;  // current compensation of the command latency
+    } STATS;
+
+    // returns false and a message with the line number on syntax errors
+    static bool compile(const QString &profile, const MP7100Protocol::MODEL &model, QVector<STEP> &steps, QString &error);
+
+    Sequencer();
+
+    void start(const QVector<STEP> &steps, qint64 nowNs);
+    void stop();
+    bool isRunning() const { return m_running; }
+    int count() const { return m_steps.size(); }
+
+    // next step to be issued, count() if all steps have been issued
+    int next() const { return m_next; }
+    const STEP &step(int n) const { return m_steps.at(n); }
+    // the next step is issued ahead of its due time by the expected latency
+    qint64 issueNs() const;
+    void issued() { m_next++; }
+    // step n issued at issuedNs has been written at nowNs, or has been
+    // replaced / dropped; returns true if this was the last step
+    bool sent(int n, qint64 issuedNs, qint64 nowNs);
+    bool skipped(int n);
+
+    STATS stats() const;
+    // jitter of the last step sent
+    double jitterMs() const { return m_lastJitterMs; }
+
+private:
+    qint64 dueNs(int n) const { return m_startNs + static_cast<qint64>(m_steps.at(n).tMs)*1000000; }
+    bool done(int n);
+
+    QVector<STEP>   m_steps;
+    bool            m_running;
+    qint64          m_startNs;
+    int             m_next;
+    double          m_latencyNs;    // smoothed issue to wire latency
+    int             m_sent;
+    int             m_skipped;
+    double          m_sumMs, m_sumSqMs, m_maxAbsMs;
+    double          m_lastJitterMs;
+};
+
+#endif // SEQUENCER_H
@@ -11,38 +11,98 @@
 // 2021-07-28  tt  Initial version created
 // ---------------------------------------------------------------------------
 #include "serdev.h"
+#include "logcategories.h"
 #include <QSerialPort>
 #include <QDebug>
 #include <QThread>
+#include <cstring>
 
-SerDev::SerDev(const QString &portName, quint32 baudrate, QObject *parent) : QObject(parent)
-  , m_port(new QSerialPort(portName, this))
+SerDev::SerDev(const QString &portName, quint32 baudrate, QObject *parent, char terminator) : QObject(parent)
+  , m_portName(portName)
+  , m_baudrate(baudrate)
+  , m_port(nullptr)
+  , m_valid(0)
+  , m_terminator(terminator)
+  , m_rxHead(0)
+  , m_rxTail(0)
+  , m_rxScan(0)
+  , m_txBytes(0)
+  , m_rxBytes(0)
 {
-    qDebug() << "Serdev::SerDev()";
-    m_port->setBaudRate(baudrate);
+    qCDebug(lcSerial) << "Serdev::SerDev()";
+}
+
+SerDev::~SerDev()
+{
+    qCDebug(lcSerial) << "Serdev::~SerDev()";
+    delete m_port;
+}
+
+bool SerDev::open()
+{
+    // the port is created here and not in the constructor, so that it lives
+    // in the same thread as the device after moveToThread()
+    delete m_port;
+    m_port = new QSerialPort(m_portName, this);
+    m_port->setBaudRate(m_baudrate);
     m_port->setStopBits(QSerialPort::OneStop);
     m_port->setParity(QSerialPort::NoParity);
     if (m_port->open(QSerialPort::ReadWrite)) {
-        qDebug().nospace() << qPrintable(portName) << ": serial port is open";
+        qCDebug(lcSerial).nospace() << qPrintable(m_portName) << ": serial port is open";
         connect(m_port, &QSerialPort::readyRead, this, &SerDev::onNewData);
+        m_valid.storeRelease(1);
     } else {
-        qDebug().nospace() << qPrintable(portName) << ": failed to open serial port";
+        qCDebug(lcSerial).nospace() << qPrintable(m_portName) << ": failed to open serial port";
         delete m_port;
         m_port = nullptr;
+        m_valid.storeRelease(0);
     }
+    return m_port != nullptr;
 }
 
-SerDev::~SerDev()
+
+void SerDev::onNewData()
 {
-    qDebug() << "Serdev::~SerDev()";
-    delete m_port;
+    for (;;) {
+        quint32 used = m_rxHead - m_rxTail;
+        if (used == RX_RING_SIZE) {
+            // a full ring without any terminator can't be decoded anyway
+            qCWarning(lcSerial) << "SerDev: receive buffer overflow, dropping" << used << "bytes";
+            m_rxTail = m_rxHead;
+            m_rxScan = m_rxHead;
+            used = 0;
+        }
+        // read straight into the contiguous free space of the ring
+        quint32 pos = m_rxHead & (RX_RING_SIZE-1);
+        quint32 space = qMin<quint32>(RX_RING_SIZE - used, RX_RING_SIZE - pos);
+        qint64 n = m_port->read(m_rxRing + pos, space);
+        if (n <= 0)
+            break;
+        m_rxHead += static_cast<quint32>(n);
+        m_rxBytes += static_cast<quint64>(n);
+        extractLines();
+    }
 }
 
-
-void SerDev::onNewData()
+void SerDev::extractLines()
 {
-    m_rxBuffer.append(m_port->readAll());
-    decodeBuffer(m_rxBuffer);
+    while (m_rxScan != m_rxHead) {
+        if (m_rxRing[m_rxScan & (RX_RING_SIZE-1)] == m_terminator) {
+            quint32 start = m_rxTail & (RX_RING_SIZE-1);
+            quint32 size = m_rxScan - m_rxTail;
+            m_rxTail = m_rxScan + 1;
+            if (start + size <= RX_RING_SIZE) {
+                decodeBuffer(m_rxRing + start, static_cast<int>(size));
+            } else {
+                // line wraps around the end of the ring
+                quint32 first = RX_RING_SIZE - start;
+                memcpy(m_rxLine, m_rxRing + start, first);
+                memcpy(m_rxLine + first, m_rxRing, size - first);
+                decodeBuffer(m_rxLine, static_cast<int>(size));
+            }
+        }
+        m_rxScan++;
+    }
 }
 
 
@@ -53,10 +113,29 @@ void SerDev::sendData(const QByteArray &data, quint32 charDelay)
             for (auto x : data) {
                 m_port->write(&x, 1);
                 m_port->flush();
+                m_txBytes++;
                 QThread::msleep(charDelay);
             }
         } else {
             m_port->write(data);
+            m_txBytes += static_cast<quint64>(data.size());
         }
     }
 }
+
+void SerDev::sendData(const char *data, int size)
+{
+    if (nullptr != m_port) {
+        m_port->write(data, size);
+        m_txBytes += static_cast<quint64>(size);
+    }
+}
+
+void SerDev::clearInput()
+{
+    if (nullptr != m_port)
+        m_port->clear(QSerialPort::Input);
+    // a partial line is dropped as well
+    m_rxTail = m_rxHead;
+    m_rxScan = m_rxHead;
+}
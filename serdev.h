@@ -14,6 +14,7 @@
 #define SERDEV_H
 
 #include <QObject>
+#include <QAtomicInt>
 
 class QSerialPort;
 
@@ -21,20 +22,50 @@ class SerDev : public QObject
 {
     Q_OBJECT
 public:
-    explicit SerDev(const QString &portName, quint32 baudrate, QObject *parent = nullptr);
-    bool isValid() const { return m_port != nullptr; }
+    explicit SerDev(const QString &portName, quint32 baudrate, QObject *parent = nullptr, char terminator = '\r');
+    bool isValid() const { return m_valid.loadAcquire() != 0; }
     ~SerDev();
 
+    // bytes sent / received since the port was opened, device thread only
+    quint64 txBytes() const { return m_txBytes; }
+    quint64 rxBytes() const { return m_rxBytes; }
+
+public slots:
+    // open the port from the thread the device lives in
+    bool open();
+
 protected:
-    virtual void decodeBuffer(QByteArray &buffer) = 0;
+    // called for every complete line received, the terminator is not included;
+    // data points into the receive buffer and is only valid during the call
+    virtual void decodeBuffer(const char *data, int size) = 0;
     void sendData(const QByteArray &data, quint32 charDelay = 0);
+    void sendData(const char *data, int size);
+    // drops all received bytes that have not been decoded yet
+    void clearInput();
+    quint32 baudrate() const { return m_baudrate; }
 
 private slots:
     void onNewData();
 
 private:
+    // receive ring buffer, size must be a power of 2
+    enum { RX_RING_SIZE = 4096 };
+    static_assert((RX_RING_SIZE & (RX_RING_SIZE-1)) == 0, "RX_RING_SIZE must be a power of 2");
+
+    void extractLines();
+
+    QString         m_portName;
+    quint32         m_baudrate;
     QSerialPort     *m_port;
-    QByteArray      m_rxBuffer;
+    QAtomicInt      m_valid;
+    char            m_terminator;
+    char            m_rxRing[RX_RING_SIZE];
+    char            m_rxLine[RX_RING_SIZE];     // lines wrapping around the ring end are assembled here
+    quint32         m_rxHead;                   // write position, free running
+    quint32         m_rxTail;                   // start of the current line, free running
+    quint32         m_rxScan;                   // terminator search position, free running
+    quint64         m_txBytes;
+    quint64         m_rxBytes;
 
 };
 
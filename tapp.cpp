@@ -62,9 +62,17 @@ TApp::TApp(int &argc, char **argv, const QString &fallbackVersion, const QString
 
 TApp::~TApp()
 {
+    // the widgets of main() and their device threads are gone already
     T_REMOVE_MSGHANDLER();
 }
 
+void TApp::saveLog(const QString &fileName)
+{
+    TLogger *logger = pTLogger.loadAcquire();
+    if (logger)
+        logger->saveMessages(fileName);
+}
+
 TMessageHandler *TApp::msgHandler()
 {
     return pTMsgHandler;
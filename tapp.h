@@ -23,6 +23,9 @@ public:
     TApp(int &argc, char **argv, const QString &fallbackVersion=QString(), const QString &fallbackName=QString());
     ~TApp();
     TMessageHandler *msgHandler();
+    // save the messages kept in memory, messageSaved() of msgHandler() is
+    // emitted when done
+    void saveLog(const QString &fileName);
 };
 
 #define tApp (static_cast<TApp *>(QCoreApplication::instance()))
@@ -0,0 +1,165 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlog.cpp
+// structured log records with lazy formatting
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlog.h"
+#include "tlogger.h"
+#include <QAtomicPointer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <cstring>
+
+// id 1 is used when the table is full, the arguments are still shown
+#define FORMAT_OVERFLOW     1
+
+typedef struct CLOCK {
+    QElapsedTimer   timer;
+    qint64          epochMs;    // wall clock time at timer = 0
+    CLOCK()
+    {
+        timer.start();
+        epochMs = QDateTime::currentMSecsSinceEpoch();
+    }
+} CLOCK;
+
+static CLOCK &logClock()
+{
+    static CLOCK clock;
+    return clock;
+}
+
+static const char *formats[TLOG_MAX_FORMATS] = { "%1", "%1 %2 %3 %4" };
+static int formatCount = 2;
+static QMutex formatLock;
+static QAtomicPointer<TLogger> logger;
+
+qint64 TLog::now()
+{
+    return logClock().timer.nsecsElapsed();
+}
+
+qint64 TLog::toMs(qint64 tNs)
+{
+    return logClock().epochMs + tNs/1000000;
+}
+
+quint16 TLog::intern(const char *format)
+{
+    QMutexLocker lock(&formatLock);
+    // call sites of the same text share one id
+    for (int n = 2; n < formatCount; ++n) {
+        if (strcmp(formats[n], format) == 0)
+            return static_cast<quint16>(n);
+    }
+    if (formatCount >= TLOG_MAX_FORMATS)
+        return FORMAT_OVERFLOW;
+    formats[formatCount] = format;
+    return static_cast<quint16>(formatCount++);
+}
+
+const char *TLog::format(quint16 id)
+{
+    // ids are published after their entry has been written
+    return (id < TLOG_MAX_FORMATS) && formats[id] ? formats[id] : "?";
+}
+
+TLOG_RECORD TLog::text(QtMsgType level, const QString &text)
+{
+    TLOG_RECORD r;
+    r.tNs = now();
+    r.format = 0;
+    r.level = static_cast<quint8>(level);
+    r.argc = 0;
+    r.text = text;
+    return r;
+}
+
+bool TLog::same(const TLOG_RECORD &a, const TLOG_RECORD &b)
+{
+    if ((a.format != b.format) || (a.level != b.level) || (a.argc != b.argc))
+        return false;
+    if (a.format == 0)
+        return a.text == b.text;
+    for (int n = 0; n < a.argc; ++n) {
+        if (a.type[n] != b.type[n])
+            return false;
+        if (a.type[n] == TLOG_ARG_CSTR) {
+            if ((a.arg[n].s != b.arg[n].s) && (strcmp(a.arg[n].s, b.arg[n].s) != 0))
+                return false;
+        } else if (a.arg[n].u != b.arg[n].u) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString TLog::message(const TLOG_RECORD &r)
+{
+    if (r.format == 0)
+        return r.text;
+    QString s = QString::fromLatin1(format(r.format));
+    for (int n = 0; n < r.argc; ++n) {
+        switch (r.type[n]) {
+        case TLOG_ARG_INT:      s = s.arg(r.arg[n].i); break;
+        case TLOG_ARG_UINT:     s = s.arg(r.arg[n].u); break;
+        case TLOG_ARG_BOOL:     s = s.arg(r.arg[n].u ? "true" : "false"); break;
+        case TLOG_ARG_DOUBLE:   s = s.arg(r.arg[n].d); break;
+        case TLOG_ARG_CSTR:     s = s.arg(QString::fromLatin1(r.arg[n].s)); break;
+        }
+    }
+    return s;
+}
+
+QString TLog::render(const TLOG_RECORD &r)
+{
+    return QDateTime::fromMSecsSinceEpoch(toMs(r.tNs)).toString("[yyyy-MM-dd hh:mm:ss.zzz] ")
+            + levelName(r.level) + message(r);
+}
+
+QString TLog::render(const TLOG_ENTRY &e)
+{
+    // the time stamp is the one of the first occurrence
+    if (e.repeat <= 1)
+        return render(e.r);
+    const qint64 dT = (e.lastNs - e.r.tNs)/1000000000;
+    if (dT)
+        return QString("%1 (repeated %2 times, within last %3 seconds)").arg(render(e.r)).arg(e.repeat).arg(dT);
+    return QString("%1 (repeated %2 times)").arg(render(e.r)).arg(e.repeat);
+}
+
+const char *TLog::levelName(int level)
+{
+    switch (level) {
+    case QtDebugMsg:    return "DBUG ";
+    case QtInfoMsg:     return "INFO ";
+    case QtWarningMsg:  return "WARN ";
+    case QtCriticalMsg: return "CRIT ";
+    case QtFatalMsg:    return "FATL ";
+    }
+    return "";
+}
+
+void TLog::setLogger(TLogger *logger)
+{
+    ::logger.storeRelease(logger);
+}
+
+void TLog::post(const TLOG_RECORD &r)
+{
+    TLogger *l = logger.loadAcquire();
+    if (l) {
+        l->log(r);
+        return;
+    }
+    // no logger running, formatted right away
+    qt_message_output(static_cast<QtMsgType>(r.level), QMessageLogContext(), message(r));
+}
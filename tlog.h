@@ -0,0 +1,160 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlog.h, header file
+// structured log records with lazy formatting
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// A record holds the id of a format string, up to TLOG_MAX_ARGS typed
+// arguments, the level and the raw time stamp. It is turned into text only
+// when it is displayed or written, by TLog::render(). Format strings use the
+// QString::arg() place holders %1..%4 and are interned once per call site:
+//   TLOG(QtInfoMsg, "send: %1 after %2 ms", mnemonic, latencyMs);
+// String arguments are stored as pointers and must be static (literals,
+// protocol tables). Messages of qDebug() etc. are kept as text records with
+// format id 0. TCLOG() takes a QLoggingCategory function as first argument
+// and returns before the arguments are evaluated if the level is disabled.
+// ***************************************************************************
+#ifndef TLOG_H
+#define TLOG_H
+
+#include <QString>
+#include <type_traits>
+
+#define TLOG_MAX_ARGS       4
+#define TLOG_MAX_FORMATS    1024
+
+typedef enum {
+    TLOG_ARG_INT,
+    TLOG_ARG_UINT,
+    TLOG_ARG_BOOL,
+    TLOG_ARG_DOUBLE,
+    TLOG_ARG_CSTR           // static string
+} TLOG_ARG_TYPE;
+
+typedef union {
+    qint64      i;
+    quint64     u;
+    double      d;
+    const char  *s;
+} TLOG_VALUE;
+
+typedef struct {
+    qint64      tNs;                    // raw time stamp, see TLog::now()
+    quint16     format;                 // format string id, 0 = text
+    quint8      level;                  // QtMsgType
+    quint8      argc;
+    quint8      type[TLOG_MAX_ARGS];    // TLOG_ARG_TYPE
+    TLOG_VALUE  arg[TLOG_MAX_ARGS];
+    QString     text;                   // text records only
+} TLOG_RECORD;
+
+// identical records are collated into one entry
+typedef struct {
+    TLOG_RECORD r;          // r.tNs is the time of the first occurrence
+    quint32     repeat;     // occurrences collated into this entry
+    qint64      lastNs;     // time of the last occurrence
+} TLOG_ENTRY;
+
+class TLogger;
+
+class TLog
+{
+public:
+    // ns since the start of the application, monotonic
+    static qint64 now();
+    // wall clock time of a raw time stamp in ms since epoch
+    static qint64 toMs(qint64 tNs);
+
+    // returns the id of format, registers it on the first call
+    static quint16 intern(const char *format);
+    static const char *format(quint16 id);
+
+    // a text record of the current time
+    static TLOG_RECORD text(QtMsgType level, const QString &text);
+
+    template<typename... A>
+    static void log(QtMsgType level, quint16 format, const A&... args)
+    {
+        static_assert(sizeof...(A) <= TLOG_MAX_ARGS, "too many log arguments");
+        TLOG_RECORD r;
+        r.tNs = now();
+        r.format = format;
+        r.level = static_cast<quint8>(level);
+        r.argc = 0;
+        int dummy[] = { 0, (setArg(r, args), 0)... };
+        Q_UNUSED(dummy)
+        post(r);
+    }
+
+    // true if both records show the same message, the time is ignored
+    static bool same(const TLOG_RECORD &a, const TLOG_RECORD &b);
+    // the message without time stamp and level
+    static QString message(const TLOG_RECORD &r);
+    // "[yyyy-MM-dd hh:mm:ss.zzz] LEVL message"
+    static QString render(const TLOG_RECORD &r);
+    // followed by " (repeated n times)"
+    static QString render(const TLOG_ENTRY &e);
+    static const char *levelName(int level);
+
+    // records are passed to logger, or to the Qt message handler if nullptr
+    static void setLogger(TLogger *logger);
+
+private:
+    static void post(const TLOG_RECORD &r);
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type setArg(TLOG_RECORD &r, T v)
+    {
+        if (std::is_same<T, bool>::value) {
+            r.type[r.argc] = TLOG_ARG_BOOL;
+            r.arg[r.argc].u = v ? 1 : 0;
+        } else if (std::is_signed<T>::value) {
+            r.type[r.argc] = TLOG_ARG_INT;
+            r.arg[r.argc].i = static_cast<qint64>(v);
+        } else {
+            r.type[r.argc] = TLOG_ARG_UINT;
+            r.arg[r.argc].u = static_cast<quint64>(v);
+        }
+        r.argc++;
+    }
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type setArg(TLOG_RECORD &r, T v)
+    {
+        r.type[r.argc] = TLOG_ARG_DOUBLE;
+        r.arg[r.argc].d = static_cast<double>(v);
+        r.argc++;
+    }
+    static void setArg(TLOG_RECORD &r, const char *s)
+    {
+        r.type[r.argc] = TLOG_ARG_CSTR;
+        r.arg[r.argc].s = s;
+        r.argc++;
+    }
+};
+
+// the format string is interned once per call site
+#define TLOG(level, format, ...) do {                           \
+    static const quint16 _tlogFormat = TLog::intern(format);    \
+    TLog::log(level, _tlogFormat, ##__VA_ARGS__);               \
+    } while (0)
+
+#define TLOG_DEBUG(format, ...)     TLOG(QtDebugMsg, format, ##__VA_ARGS__)
+#define TLOG_INFO(format, ...)      TLOG(QtInfoMsg, format, ##__VA_ARGS__)
+#define TLOG_WARNING(format, ...)   TLOG(QtWarningMsg, format, ##__VA_ARGS__)
+
+#define TCLOG(category, level, format, ...) do {                \
+    if (category().isEnabled(level))                            \
+        TLOG(level, format, ##__VA_ARGS__);                     \
+    } while (0)
+
+#define TCLOG_DEBUG(category, format, ...)      TCLOG(category, QtDebugMsg, format, ##__VA_ARGS__)
+#define TCLOG_INFO(category, format, ...)       TCLOG(category, QtInfoMsg, format, ##__VA_ARGS__)
+#define TCLOG_WARNING(category, format, ...)    TCLOG(category, QtWarningMsg, format, ##__VA_ARGS__)
+
+#endif // TLOG_H
@@ -0,0 +1,18 @@
+# asynchronous logging, shared by the application and bench/logger
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/tlog.cpp \
+    $$PWD/tlogarena.cpp \
+    $$PWD/tlogfilesink.cpp \
+    $$PWD/tlogger.cpp \
+    $$PWD/tmessagehandler.cpp
+
+HEADERS += \
+    $$PWD/tlog.h \
+    $$PWD/tlogarena.h \
+    $$PWD/tlogfilesink.h \
+    $$PWD/tlogger.h \
+    $$PWD/tmessagehandler.h \
+    $$PWD/tmpscqueue.h
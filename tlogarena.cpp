@@ -0,0 +1,137 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogarena.cpp
+// compact in-memory store of log records
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlogarena.h"
+#include <cstring>
+
+static_assert(sizeof(TLOG_VALUE) == 8, "unexpected size of TLOG_VALUE");
+
+TLogArena::TLogArena(int maxBytes)
+    : m_maxChunks(maxBytes > 0 ? qMax(1, maxBytes/CHUNK_SIZE) : 0)
+    , m_count(0)
+{
+}
+
+void TLogArena::append(const TLOG_ENTRY &e)
+{
+    QByteArray text;
+    if (e.r.format == 0)
+        text = e.r.text.left(MAX_TEXT).toUtf8().left(MAX_TEXT);
+    const int argBytes = e.r.argc*static_cast<int>(sizeof(TLOG_VALUE));
+    const int size = (static_cast<int>(sizeof(HEADER)) + argBytes + text.size() + 7) & ~7;
+    if (m_chunks.isEmpty() || (m_chunks.last().used + size > CHUNK_SIZE)) {
+        if (m_maxChunks && (m_chunks.size() >= m_maxChunks)) {
+            // the oldest chunk is reused
+            CHUNK c = m_chunks.takeFirst();
+            m_count -= c.offset.size() - c.first;
+            c.used = 0;
+            c.first = 0;
+            c.offset.clear();
+            m_chunks.append(c);
+        } else {
+            m_chunks.append(newChunk());
+        }
+    }
+    CHUNK &c = m_chunks.last();
+    char *p = c.data.data() + c.used;
+    HEADER h;
+    h.firstNs = e.r.tNs;
+    h.lastNs = e.lastNs;
+    h.repeat = e.repeat;
+    h.size = static_cast<quint16>(size);
+    h.format = e.r.format;
+    h.level = e.r.level;
+    h.argc = e.r.argc;
+    memcpy(h.type, e.r.type, sizeof(h.type));
+    memcpy(p, &h, sizeof(h));
+    memcpy(p + sizeof(h), e.r.arg, argBytes);
+    memcpy(p + sizeof(h) + argBytes, text.constData(), text.size());
+    // the padding holds the length of the text implicitly, it is zero
+    memset(p + sizeof(h) + argBytes + text.size(), 0, size - sizeof(h) - argBytes - text.size());
+    c.offset.append(static_cast<quint16>(c.used));
+    c.used += size;
+    m_count++;
+}
+
+void TLogArena::clear()
+{
+    if (!m_chunks.isEmpty())
+        m_spare = m_chunks.first().data;
+    m_chunks.clear();
+    m_count = 0;
+}
+
+void TLogArena::removeFirst(int n)
+{
+    n = qMin(n, m_count);
+    m_count -= qMax(0, n);
+    while (n > 0) {
+        CHUNK &c = m_chunks.first();
+        const int remove = qMin(n, c.offset.size() - c.first);
+        c.first += remove;
+        n -= remove;
+        if (c.first >= c.offset.size())
+            m_spare = m_chunks.takeFirst().data;
+    }
+}
+
+bool TLogArena::at(int n, TLOG_ENTRY &e) const
+{
+    if ((n < 0) || (n >= m_count))
+        return false;
+    for (const CHUNK &c : m_chunks) {
+        const int count = c.offset.size() - c.first;
+        if (n < count) {
+            decode(c.data.constData() + c.offset.at(c.first + n), e);
+            return true;
+        }
+        n -= count;
+    }
+    return false;
+}
+
+TLogArena::CHUNK TLogArena::newChunk()
+{
+    CHUNK c;
+    if (m_spare.isEmpty()) {
+        c.data = QByteArray(CHUNK_SIZE, Qt::Uninitialized);
+    } else {
+        c.data = m_spare;
+        m_spare.clear();
+    }
+    c.used = 0;
+    c.first = 0;
+    c.offset.reserve(CHUNK_SIZE/64);
+    return c;
+}
+
+int TLogArena::decode(const char *p, TLOG_ENTRY &e)
+{
+    HEADER h;
+    memcpy(&h, p, sizeof(h));
+    e.r.tNs = h.firstNs;
+    e.lastNs = h.lastNs;
+    e.repeat = h.repeat;
+    e.r.format = h.format;
+    e.r.level = h.level;
+    e.r.argc = h.argc;
+    memcpy(e.r.type, h.type, sizeof(h.type));
+    const int argBytes = h.argc*static_cast<int>(sizeof(TLOG_VALUE));
+    memcpy(e.r.arg, p + sizeof(h), argBytes);
+    if (h.format == 0) {
+        const char *text = p + sizeof(h) + argBytes;
+        e.r.text = QString::fromUtf8(text, static_cast<int>(strnlen(text, h.size - sizeof(h) - argBytes)));
+    } else {
+        e.r.text.clear();
+    }
+    return h.size;
+}
@@ -0,0 +1,92 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogarena.h, header file
+// compact in-memory store of log records
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Entries are packed back to back into chunks of CHUNK_SIZE bytes: a 32 byte
+// header, 8 bytes per argument and the UTF-8 text of text records. A typical
+// protocol message takes 40 bytes instead of a formatted QString in a list
+// node. Each chunk keeps the offsets of its entries, so at() decodes a single
+// entry without walking the chunk. When maxBytes are used the oldest chunk is
+// recycled, so the newest entries are kept with a fixed amount of memory
+// (0 = no limit, removeFirst() drops the oldest entries). Not thread safe.
+// ***************************************************************************
+#ifndef TLOGARENA_H
+#define TLOGARENA_H
+
+#include "tlog.h"
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+
+class TLogArena
+{
+public:
+    enum {
+        CHUNK_SIZE = 65536,
+        MAX_TEXT = 4096         // longer texts are truncated
+    };
+
+    explicit TLogArena(int maxBytes = 0);
+
+    void append(const TLOG_ENTRY &e);
+    void clear();
+    // removes the n oldest entries
+    void removeFirst(int n);
+    int count() const { return m_count; }
+    int maxBytes() const { return m_maxChunks*CHUNK_SIZE; }
+    // decodes entry n, 0 is the oldest one
+    bool at(int n, TLOG_ENTRY &e) const;
+
+    // calls f(const TLOG_ENTRY &) for all entries, oldest first
+    template<typename F>
+    void forEach(F f) const
+    {
+        TLOG_ENTRY e;
+        for (const CHUNK &c : m_chunks) {
+            for (int n = c.first; n < c.offset.size(); ++n) {
+                decode(c.data.constData() + c.offset.at(n), e);
+                f(e);
+            }
+        }
+    }
+
+private:
+    typedef struct {
+        qint64      firstNs;
+        qint64      lastNs;
+        quint32     repeat;
+        quint16     size;       // of the entry, a multiple of 8
+        quint16     format;
+        quint8      level;
+        quint8      argc;
+        quint8      type[TLOG_MAX_ARGS];
+    } HEADER;
+
+    typedef struct {
+        QByteArray          data;
+        int                 used;
+        int                 first;      // entries before were removed
+        QVector<quint16>    offset;     // of each entry in data
+    } CHUNK;
+
+    // an empty chunk, recycled if possible
+    CHUNK newChunk();
+
+    // returns the size of the entry
+    static int decode(const char *p, TLOG_ENTRY &e);
+
+    QList<CHUNK>    m_chunks;
+    QByteArray      m_spare;        // data of the last removed chunk
+    int             m_maxChunks;    // 0 = no limit
+    int             m_count;
+};
+
+#endif // TLOGARENA_H
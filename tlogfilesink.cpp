@@ -0,0 +1,139 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogfilesink.cpp
+// streaming log file with rotation
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlogfilesink.h"
+#include <QDateTime>
+#include <cstdio>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+TLogFileSink::TLogFileSink(const QString &fileName, qint64 maxBytes, qint64 maxAgeMs, int keep)
+    : m_fileName(fileName)
+    , m_maxBytes(maxBytes)
+    , m_maxAgeMs(maxAgeMs)
+    , m_keep(qMax(1, keep))
+    , m_size(0)
+    , m_ageMs(0)
+    , m_dirty(false)
+{
+    m_buffer.reserve(BUFFER_SIZE);
+    m_lastSync.start();
+    // the log of the previous run is continued
+    if (!m_fileName.isEmpty())
+        open(false);
+}
+
+TLogFileSink::~TLogFileSink()
+{
+    close();
+}
+
+bool TLogFileSink::open(bool truncate)
+{
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QFile::WriteOnly | (truncate ? QFile::Truncate : QFile::Append))) {
+        // the logger can't log its own errors
+        fprintf(stderr, "cannot open log file %s: %s\n", qPrintable(m_fileName), qPrintable(m_file.errorString()));
+        return false;
+    }
+    m_size = m_file.size();
+    // a continued file keeps its age
+    m_ageMs = (m_size > 0) ? fileAgeMs() : 0;
+    m_age.start();
+    return true;
+}
+
+qint64 TLogFileSink::fileAgeMs() const
+{
+    // the creation time is not available on all file systems, the first line
+    // starts with the time stamp of the first message instead
+    QFile f(m_fileName);
+    if (f.open(QFile::ReadOnly)) {
+        const QByteArray line = f.read(TIME_STAMP_SIZE);
+        const QDateTime created = QDateTime::fromString(QString::fromLatin1(line), "[yyyy-MM-dd hh:mm:ss.zzz]");
+        if (created.isValid())
+            return qMax<qint64>(0, QDateTime::currentMSecsSinceEpoch() - created.toMSecsSinceEpoch());
+    }
+    // unknown, rotated with the next line
+    return m_maxAgeMs;
+}
+
+void TLogFileSink::write(const QString &line)
+{
+    if (!m_file.isOpen())
+        return;
+    if (((m_maxBytes > 0) && (m_size >= m_maxBytes)) || expired())
+        rotate();
+    const QByteArray data = line.toUtf8();
+    if (m_buffer.size() + data.size() + 1 > BUFFER_SIZE)
+        writeBuffer();
+    m_buffer.append(data);
+    m_buffer.append('\n');
+    m_size += data.size() + 1;
+}
+
+void TLogFileSink::writeBuffer()
+{
+    if (m_buffer.isEmpty())
+        return;
+    if (m_file.write(m_buffer) != m_buffer.size())
+        fprintf(stderr, "cannot write log file %s: %s\n", qPrintable(m_fileName), qPrintable(m_file.errorString()));
+    // the capacity is kept, no allocation for the next lines
+    m_buffer.resize(0);
+    m_dirty = true;
+}
+
+void TLogFileSink::flush()
+{
+    if (!m_file.isOpen())
+        return;
+    writeBuffer();
+    m_file.flush();
+    if (m_dirty && m_lastSync.hasExpired(SYNC_INTERVAL_MS))
+        sync();
+}
+
+void TLogFileSink::sync()
+{
+    if (!m_file.isOpen())
+        return;
+    writeBuffer();
+    m_file.flush();
+#ifdef Q_OS_WIN
+    _commit(m_file.handle());
+#else
+    fsync(m_file.handle());
+#endif
+    m_dirty = false;
+    m_lastSync.restart();
+}
+
+void TLogFileSink::close()
+{
+    if (!m_file.isOpen())
+        return;
+    sync();
+    m_file.close();
+}
+
+void TLogFileSink::rotate()
+{
+    close();
+    QFile::remove(backupName(m_keep));
+    for (int n = m_keep - 1; n >= 1; --n)
+        QFile::rename(backupName(n), backupName(n + 1));
+    QFile::rename(m_fileName, backupName(1));
+    open(true);
+}
@@ -0,0 +1,79 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogfilesink.h, header file
+// streaming log file with rotation
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Lines are collected in a buffer of BUFFER_SIZE and appended to the file
+// when it is full or flush() is called, the file is synced to disk every
+// SYNC_INTERVAL_MS. When the file exceeds maxBytes or is older than maxAgeMs
+// it is renamed to <fileName>.1, older files are shifted up to
+// <fileName>.<keep> and the oldest one is removed. The age of a continued file
+// is taken from the "[yyyy-MM-dd hh:mm:ss.zzz]" time stamp its first line
+// starts with, a file without it is rotated. Memory use does not depend on
+// the run length. Not thread safe, used by the TLogger writer thread.
+// ***************************************************************************
+#ifndef TLOGFILESINK_H
+#define TLOGFILESINK_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+class TLogFileSink
+{
+public:
+    enum {
+        BUFFER_SIZE = 65536,
+        TIME_STAMP_SIZE = 25,       // "[yyyy-MM-dd hh:mm:ss.zzz]"
+        SYNC_INTERVAL_MS = 1000,
+        DEFAULT_KEEP = 4
+    };
+    static const qint64 DEFAULT_MAX_BYTES = 16*1024*1024;
+    static const qint64 DEFAULT_MAX_AGE_MS = 24*3600*1000;
+
+    // maxBytes or maxAgeMs <= 0 disable the rotation by size or time
+    explicit TLogFileSink(const QString &fileName, qint64 maxBytes = DEFAULT_MAX_BYTES,
+                          qint64 maxAgeMs = DEFAULT_MAX_AGE_MS, int keep = DEFAULT_KEEP);
+    ~TLogFileSink();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString fileName() const { return m_fileName; }
+
+    // appends a line feed
+    void write(const QString &line);
+    // writes the buffer to the file, syncs it every SYNC_INTERVAL_MS
+    void flush();
+    // writes the buffer and syncs the file to disk
+    void sync();
+    void close();
+
+private:
+    bool open(bool truncate);
+    void writeBuffer();
+    void rotate();
+    qint64 fileAgeMs() const;
+    bool expired() const { return (m_maxAgeMs > 0) && (m_ageMs + m_age.elapsed() >= m_maxAgeMs); }
+    QString backupName(int n) const { return QString("%1.%2").arg(m_fileName).arg(n); }
+
+    QString         m_fileName;
+    qint64          m_maxBytes;
+    qint64          m_maxAgeMs;
+    int             m_keep;
+    QFile           m_file;
+    QByteArray      m_buffer;
+    qint64          m_size;         // file size including the buffer
+    qint64          m_ageMs;        // of the file when it was opened
+    QElapsedTimer   m_age;          // since the file was opened
+    QElapsedTimer   m_lastSync;
+    bool            m_dirty;        // written since the last sync
+};
+
+#endif // TLOGFILESINK_H
@@ -0,0 +1,118 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogger.cpp
+// asynchronous logger with a background writer thread
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlogger.h"
+#include "tmessagehandler.h"
+#include <QTimerEvent>
+#include <cstdio>
+
+// interval of the writer thread
+#define LOG_DRAIN_MS    20
+
+TLogger::TLogger(TMessageHandler *handler)
+    : m_handler(handler)
+    , m_idTimer(0)
+    , m_dropped(0)
+    , m_reported(0)
+{
+    m_thread.setObjectName("logger");
+}
+
+TLogger::~TLogger()
+{
+    stop();
+}
+
+void TLogger::start()
+{
+    if (m_thread.isRunning())
+        return;
+    moveToThread(&m_thread);
+    m_thread.start(QThread::LowPriority);
+    TLog::setLogger(this);
+    QMetaObject::invokeMethod(this, [this]() { m_idTimer = startTimer(LOG_DRAIN_MS); }, Qt::QueuedConnection);
+}
+
+void TLogger::stop()
+{
+    if (!m_thread.isRunning())
+        return;
+    TLog::setLogger(nullptr);
+    // the timer must be killed in the writer thread
+    QMetaObject::invokeMethod(this, [this]() {
+        killTimer(m_idTimer);
+        m_idTimer = 0;
+    }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    // the caller is the only consumer now
+    drain();
+}
+
+// debug messages are filtered by their logging category before
+bool TLogger::log(QtMsgType type, const QString &text)
+{
+    return log(TLog::text(type, text));
+}
+
+bool TLogger::log(const TLOG_RECORD &r)
+{
+    if (m_queue.push(r))
+        return true;
+    m_dropped.fetchAndAddRelaxed(1);
+    return false;
+}
+
+void TLogger::saveMessages(const QString &fileName)
+{
+    if (m_handler == nullptr)
+        return;
+    // the handler is only used by the writer thread while it runs
+    if (m_thread.isRunning())
+        QMetaObject::invokeMethod(this, [this, fileName]() { m_handler->saveMessages(fileName); }, Qt::QueuedConnection);
+    else
+        m_handler->saveMessages(fileName);
+}
+
+void TLogger::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_idTimer)
+        drain();
+}
+
+void TLogger::drain()
+{
+    TLOG_RECORD r;
+    while (m_queue.pop(r))
+        write(r);
+    const quint32 dropped = m_dropped.loadRelaxed();
+    if (dropped != m_reported) {
+        write(TLog::text(QtWarningMsg, QString("logger: %1 messages dropped").arg(dropped - m_reported)));
+        m_reported = dropped;
+    }
+    if (m_handler)
+        m_handler->flush();
+}
+
+void TLogger::write(const TLOG_RECORD &r)
+{
+    if (m_handler) {
+        m_handler->addMessage(r);
+#ifndef QT_DEBUG
+        return;
+#endif
+    }
+    // always print to stderr in DEBUG mode
+    FILE *out = (r.level == QtDebugMsg) || (r.level == QtInfoMsg) ? stdout : stderr;
+    fprintf(out, "%s\n", qPrintable(TLog::render(r)));
+    fflush(out);
+}
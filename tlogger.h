@@ -0,0 +1,69 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogger.h, header file
+// asynchronous logger with a background writer thread
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// log() only reads the clock and pushes a record into a lock-free queue, the
+// text is shared and not copied. The writer thread drains the queue every
+// LOG_DRAIN_MS and passes the records on to the TMessageHandler (collation,
+// GUI and log file) or prints them to stdout / stderr. While the logger runs
+// it receives the structured records of TLOG() as well.
+// ***************************************************************************
+#ifndef TLOGGER_H
+#define TLOGGER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include "tlog.h"
+#include "tmpscqueue.h"
+
+class TMessageHandler;
+
+class TLogger : public QObject
+{
+    Q_OBJECT
+
+public:
+    // handler may be nullptr, messages are printed to stdout / stderr then
+    explicit TLogger(TMessageHandler *handler);
+    ~TLogger();
+
+    // start and stop the writer thread, stop() writes all pending messages
+    void start();
+    void stop();
+
+    // may be called from any thread, return false if the queue is full
+    bool log(QtMsgType type, const QString &text);
+    bool log(const TLOG_RECORD &r);
+    // the messages kept in memory by the handler are saved by the writer
+    // thread, may be called from any thread
+    void saveMessages(const QString &fileName);
+    // messages lost because the queue was full
+    quint32 dropped() const { return m_dropped.loadRelaxed(); }
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    enum { QUEUE_SIZE = 4096 };
+
+    void drain();
+    void write(const TLOG_RECORD &r);
+
+    TMpscQueue<TLOG_RECORD, QUEUE_SIZE> m_queue;
+    QThread                 m_thread;
+    TMessageHandler         *m_handler;
+    int                     m_idTimer;
+    QAtomicInteger<quint32> m_dropped;
+    quint32                 m_reported;     // dropped messages already reported
+};
+
+#endif // TLOGGER_H
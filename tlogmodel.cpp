@@ -0,0 +1,97 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogmodel.cpp
+// list model of the newest log messages
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+#include "tlogmodel.h"
+#include <QColor>
+#include <QTimerEvent>
+
+TLogModel::TLogModel(int maxRows, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_maxRows(qMax(1, maxRows))
+    , m_idFrameTimer(0)
+    , m_showDebug(false)
+{
+}
+
+int TLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.count();
+}
+
+QVariant TLogModel::data(const QModelIndex &index, int role) const
+{
+    TLOG_ENTRY e;
+    if (!index.isValid() || !m_rows.at(index.row(), e))
+        return QVariant();
+    switch (role) {
+    case Qt::DisplayRole:
+        // only the rows in view are formatted
+        return TLog::render(e);
+    case Qt::ForegroundRole:
+        switch (e.r.level) {
+        case QtDebugMsg:    return QColor("gray");
+        case QtInfoMsg:     return QColor("black");
+        case QtWarningMsg:  return QColor("mediumblue");
+        case QtCriticalMsg: return QColor("firebrick");
+        case QtFatalMsg:    return QColor("darkviolet");
+        }
+        break;
+    }
+    return QVariant();
+}
+
+void TLogModel::append(const QVector<TLOG_ENTRY> &entries)
+{
+    for (const TLOG_ENTRY &e : entries) {
+        if (m_showDebug || (e.r.level != QtDebugMsg))
+            m_pending.append(e);
+    }
+    if (!m_pending.isEmpty() && (m_idFrameTimer == 0))
+        m_idFrameTimer = startTimer(FRAME_MS, Qt::PreciseTimer);
+}
+
+void TLogModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_pending.clear();
+    endResetModel();
+}
+
+void TLogModel::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_idFrameTimer) {
+        killTimer(m_idFrameTimer);
+        m_idFrameTimer = 0;
+        flush();
+    }
+}
+
+void TLogModel::flush()
+{
+    if (m_pending.isEmpty())
+        return;
+    // entries that would be pushed out in the same frame are never shown
+    const int skip = qMax(0, m_pending.size() - m_maxRows);
+    const int count = m_pending.size() - skip;
+    const int remove = qMax(0, m_rows.count() + count - m_maxRows);
+    if (remove > 0) {
+        beginRemoveRows(QModelIndex(), 0, remove - 1);
+        m_rows.removeFirst(remove);
+        endRemoveRows();
+    }
+    beginInsertRows(QModelIndex(), m_rows.count(), m_rows.count() + count - 1);
+    for (int n = skip; n < m_pending.size(); ++n)
+        m_rows.append(m_pending.at(n));
+    endInsertRows();
+    m_pending.clear();
+}
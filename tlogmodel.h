@@ -0,0 +1,64 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tlogmodel.h, header file
+// list model of the newest log messages
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// The newest maxRows log entries are kept as compact records in a TLogArena,
+// a QListView with uniform item sizes decodes and formats only the visible
+// rows. Incoming messages are collected
+// and inserted at most once per FRAME_MS, so a burst of messages costs one
+// model update per frame. Rows are coloured by their level.
+// ***************************************************************************
+#ifndef TLOGMODEL_H
+#define TLOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include "tlog.h"
+#include "tlogarena.h"
+
+class TLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum {
+        DEFAULT_ROWS = 10000,
+        FRAME_MS = 16
+    };
+
+    explicit TLogModel(int maxRows = DEFAULT_ROWS, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // debug messages are dropped unless shown
+    void setShowDebug(bool show) { m_showDebug = show; }
+    bool showDebug() const { return m_showDebug; }
+
+public slots:
+    // collected until the next frame
+    void append(const QVector<TLOG_ENTRY> &entries);
+    void clear();
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void flush();
+
+    TLogArena           m_rows;     // up to m_maxRows entries, row 0 first
+    int                 m_maxRows;
+    QVector<TLOG_ENTRY> m_pending;  // until the next frame
+    int                 m_idFrameTimer;
+    bool                m_showDebug;
+};
+
+#endif // TLOGMODEL_H
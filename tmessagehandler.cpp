@@ -16,20 +16,21 @@
 #include <QFile>
 #include <QTextStream>
 
-#define MESSAGE_LIMIT   10000
-static const int msgCollateTime = 5;   // print out identical messages after 5 seconds, latest
+static const int msgCollateTime = 5000;    // print out identical messages after 5 seconds, latest
 
-TMessageHandler::TMessageHandler(const QString &filename, QObject *parent)
+TMessageHandler::TMessageHandler(const QString &filename, int tailBytes, QObject *parent)
     : QObject(parent)
-    , m_filename(filename)
+    , m_msg(tailBytes)
+    , m_keepTail(tailBytes > 0)
+    , m_sink(filename)
 {
 #ifdef QT_DEBUG
     fprintf(stderr, "+++ TMessageHandler::TMessageHandler()\n");
 #endif
     qRegisterMetaType<TMessageHandler*>("TMessageHandlerStar");
-    m_lastMsg.text = QString();
-    m_lastMsg.firstTime = QDateTime::currentMSecsSinceEpoch();
-    m_lastMsg.lastTime = m_lastMsg.firstTime;
+    qRegisterMetaType<QVector<TLOG_ENTRY>>("QVector<TLOG_ENTRY>");
+    m_lastMsg.r = TLog::text(QtDebugMsg, QString());
+    m_lastMsg.lastNs = m_lastMsg.r.tNs;
     m_lastMsg.repeat = 0;
 #ifdef QT_DEBUG
     fprintf(stderr, "--- TMessageHandler::TMessageHandler()\n");
@@ -41,36 +42,37 @@ TMessageHandler::~TMessageHandler()
 #ifdef QT_DEBUG
     fprintf(stderr, "+++ TMessageHandler::~TMessageHandler()\n");
 #endif
-    saveMessages(m_filename);
+    // pending repetitions of the last message
+    if (m_lastMsg.repeat)
+        append(m_lastMsg);
+    m_sink.close();
 #ifdef QT_DEBUG
     fprintf(stderr, "--- TMessageHandler::~TMessageHandler()\n");
 #endif
 }
 
-void TMessageHandler::addMessage(const QString &text)
+void TMessageHandler::addMessage(const TLOG_RECORD &r)
 {
 #ifdef QT_DEBUG
     //fprintf(stderr, "+++ TMessageHandler::addMessage()\n");
 #endif
-    MSG_ENTRY msg;
-    msg.text = text;
-    msg.lastTime = QDateTime::currentMSecsSinceEpoch();
-    msg.repeat = 0;
-    if (msg.text != m_lastMsg.text) {
+    // format ids and arguments are compared, no text is formatted here
+    if (!TLog::same(r, m_lastMsg.r)) {
         //this is a new message
         if (m_lastMsg.repeat)
             append(m_lastMsg);
-        append(msg);
-        m_lastMsg = msg;
-        m_lastMsg.firstTime = msg.lastTime;
+        m_lastMsg.r = r;
+        m_lastMsg.lastNs = r.tNs;
+        m_lastMsg.repeat = 0;
+        append(m_lastMsg);
     } else {
         m_lastMsg.repeat++;
-        m_lastMsg.lastTime = msg.lastTime;
-        if ((m_lastMsg.lastTime - m_lastMsg.firstTime) >= msgCollateTime) {
+        m_lastMsg.lastNs = r.tNs;
+        if ((m_lastMsg.lastNs - m_lastMsg.r.tNs) >= msgCollateTime*1000000LL) {
             // repeated same message for too long -> print out message
             append(m_lastMsg);
             m_lastMsg.repeat = 0;
-            m_lastMsg.firstTime = m_lastMsg.lastTime;
+            m_lastMsg.r.tNs = m_lastMsg.lastNs;
         }
     }
 #ifdef QT_DEBUG
@@ -83,22 +85,13 @@ void TMessageHandler::saveMessages(const QString &fileName)
 #ifdef QT_DEBUG
     fprintf(stderr, "+++ TMessageHandler::saveMessages(fileName=\"%s\")\n", fileName.toLocal8Bit().constData());
 #endif
-    if (m_msg.size()) {
+    if (m_msg.count()) {
         QFile f(fileName);
         if (f.open(QFile::WriteOnly | QFile::Truncate)) {
             QTextStream t(&f);
-            for(MSG_ENTRY &msg : m_msg) {
-                t << QDateTime::fromMSecsSinceEpoch(msg.lastTime).toString("[yyyy-MM-dd hh:mm:ss.zzz] ") + msg.text;
-                if (msg.repeat > 1) {
-                    t << " (repeated " << msg.repeat << " times";
-                    uint dT = msg.lastTime - msg.firstTime;
-                    if (dT)
-                        t << ", within last " << dT << " seconds)";
-                    else
-                        t << ")";
-                }
-                t << Qt::endl;
-            }
+            m_msg.forEach([&t](const TLOG_ENTRY &msg) {
+                t << TLog::render(msg) << Qt::endl;
+            });
             f.close();
             emit messageSaved();
 #ifdef QT_DEBUG
@@ -111,10 +104,22 @@ void TMessageHandler::saveMessages(const QString &fileName)
 #endif
 }
 
-void TMessageHandler::append(const MSG_ENTRY &msg)
+void TMessageHandler::flush()
 {
-    if (m_msg.size() >= MESSAGE_LIMIT)
-        m_msg.removeFirst();
-    m_msg.append(msg);
-    emit messageAdded(msg.text);
+    m_sink.flush();
+    if (!m_pending.isEmpty()) {
+        emit messagesAdded(m_pending);
+        m_pending.clear();
+    }
+}
+
+void TMessageHandler::append(const TLOG_ENTRY &msg)
+{
+    // the log file is the only place a message is formatted right away
+    m_sink.write(TLog::render(msg));
+    if (m_keepTail)
+        m_msg.append(msg);
+    // without a TLogger calling flush() nobody collects them
+    if (m_pending.size() < MAX_PENDING)
+        m_pending.append(msg);
 }
@@ -21,41 +21,51 @@
 #include <QObject>
 #include <QMetaType>
 #include <QStringList>
+#include <QVector>
 #include <QDateTime>
+#include "tlogarena.h"
+#include "tlogfilesink.h"
 
 class TMessageHandler : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit TMessageHandler(const QString &filename, QObject *parent = nullptr);
+    enum {
+        DEFAULT_TAIL_BYTES = 1024*1024,
+        MAX_PENDING = 10000
+    };
+
+    // messages are streamed into filename, the newest messages are kept in
+    // tailBytes of memory as well for saveMessages() (0 = none)
+    explicit TMessageHandler(const QString &filename, int tailBytes = DEFAULT_TAIL_BYTES, QObject *parent = nullptr);
     ~TMessageHandler();
 
-public slots:
-    void addMessage(const QString &text);
+    // write buffered messages to the log file and pass the new messages on
+    // to messagesAdded(), called by TLogger after every batch
+    void flush();
+
+    // called by TLogger in its writer thread
+    void addMessage(const TLOG_RECORD &r);
+    // save the messages kept in memory, called in the writer thread as well,
+    // see TLogger::saveMessages()
     void saveMessages(const QString &fileName);
 
 signals:
-    void messageAdded(const QString &msg);
+    void messagesAdded(const QVector<TLOG_ENTRY> &msg);
     void messageSaved();
 
 private:
-    typedef struct
-    {
-        QString     text;
-        int         repeat;
-        qint64      firstTime;
-        qint64      lastTime;
-    } MSG_ENTRY;
-
-    QList<MSG_ENTRY>    m_msg;
-    MSG_ENTRY           m_lastMsg;
-
-    void append(const MSG_ENTRY &msg);
+    void append(const TLOG_ENTRY &msg);
 
-    QString         m_filename;
+    TLogArena       m_msg;
+    TLOG_ENTRY      m_lastMsg;
+    QVector<TLOG_ENTRY> m_pending;  // since the last flush()
+    bool            m_keepTail;
+    TLogFileSink    m_sink;
 };
 
 Q_DECLARE_METATYPE(TMessageHandler*)
+Q_DECLARE_METATYPE(TLOG_ENTRY)
 
 #endif // TMESSAGEHANDLER_H
@@ -0,0 +1,87 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tmpscqueue.h
+// bounded lock-free multiple producer / single consumer queue
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// push() may be called from any number of threads, pop() from one thread
+// only. N must be a power of 2. Every slot carries a sequence number that
+// tells producers and the consumer whose turn it is (D. Vyukov's bounded
+// queue), a producer claims a slot with a single compare and swap.
+// Popped items are reset in the consumer thread, so e.g. the memory of a
+// QString is released there and not by the next producer.
+// ***************************************************************************
+#ifndef TMPSCQUEUE_H
+#define TMPSCQUEUE_H
+
+#include <QAtomicInteger>
+
+template<typename T, int N>
+class TMpscQueue
+{
+    static_assert((N > 0) && ((N & (N-1)) == 0), "N must be a power of 2");
+
+public:
+    TMpscQueue() : m_head(0), m_tail(0)
+    {
+        for (int n = 0; n < N; ++n)
+            m_slots[n].seq.storeRelaxed(static_cast<quint32>(n));
+    }
+
+    // producer side, any thread, returns false if the queue is full
+    bool push(const T &item)
+    {
+        quint32 head = m_head.loadRelaxed();
+        for (;;) {
+            SLOT &s = m_slots[head & (N-1)];
+            const qint32 diff = static_cast<qint32>(s.seq.loadAcquire() - head);
+            if (diff == 0) {
+                // the slot is free, claim it; head is updated on failure
+                if (m_head.testAndSetRelaxed(head, head + 1, head)) {
+                    s.item = item;
+                    s.seq.storeRelease(head + 1);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // the consumer has not popped this slot of the previous round
+                return false;
+            } else {
+                // another producer has claimed the slot in the meantime
+                head = m_head.loadRelaxed();
+            }
+        }
+    }
+
+    // consumer side, returns false if the queue is empty or the next item
+    // is still being written
+    bool pop(T &item)
+    {
+        SLOT &s = m_slots[m_tail & (N-1)];
+        if (static_cast<qint32>(s.seq.loadAcquire() - (m_tail + 1)) < 0)
+            return false;
+        item = s.item;
+        s.item = T();
+        s.seq.storeRelease(m_tail + N);
+        m_tail++;
+        return true;
+    }
+
+private:
+    typedef struct {
+        QAtomicInteger<quint32> seq;
+        T                       item;
+    } SLOT;
+
+    SLOT                                m_slots[N];
+    // keep producer and consumer index on separate cache lines
+    alignas(64) QAtomicInteger<quint32> m_head;
+    alignas(64) quint32                 m_tail;     // consumer only
+};
+
+#endif // TMPSCQUEUE_H
@@ -14,40 +14,70 @@
 #define TMSGHANDLER_MAIN_H
 
 #include "tmessagehandler.h"
+#include "tlogger.h"
+#include <QAtomicPointer>
+#include <QThread>
 
+// messages are passed to pTLogger and written by its thread
 #define T_INSTALL_MSGHANDLER(filename) {               \
     pTMsgHandler = new TMessageHandler(filename); \
+    TLogger *logger = new TLogger(pTMsgHandler);       \
+    logger->start();                                   \
+    pTLogger.storeRelease(logger);                     \
     qInstallMessageHandler(_TMessageHandler);          \
     }
 
+// all other threads that log must have been joined before, a message of a
+// thread still running could reach the logger while it is deleted
 #define T_REMOVE_MSGHANDLER() {                        \
+    delete pTLogger.fetchAndStoreOrdered(nullptr);     \
     delete pTMsgHandler;                               \
+    pTMsgHandler = nullptr;                            \
     }
 
 static TMessageHandler *pTMsgHandler = nullptr;
+static QAtomicPointer<TLogger> pTLogger;
 
 void _TMessageHandler(QtMsgType t, const QMessageLogContext &context, const QString &msg)
 {
     Q_UNUSED(context)
+    // fast path, no formatting in the caller's thread
+    TLogger *logger = pTLogger.loadAcquire();
+    if (logger && (t != QtFatalMsg)) {
+        logger->log(t, msg);
+        return;
+    }
     QString tag = QDateTime::currentDateTime().toString("[yyyy-MM-dd hh:mm:ss.zzz] ");
+    if (logger && (logger->thread() != QThread::currentThread())) {
+        // the pending messages and the fatal one are written before the
+        // application is aborted. Not possible in the writer thread itself.
+        logger->log(t, msg);
+        logger->stop();
+#ifndef QT_DEBUG
+        // printed by the logger in DEBUG mode
+        fprintf(stderr, "%s FATL %s\n", qPrintable(tag), qPrintable(msg));
+#endif
+        abort();
+    }
     if (pTMsgHandler) {
         switch (t) {
         case QtDebugMsg:
 #ifdef QT_DEBUG
-            pTMsgHandler->addMessage(tag + "DBUG " + msg);
+            pTMsgHandler->addMessage(TLog::text(t, msg));
 #endif
             break;
         case QtInfoMsg:
-            pTMsgHandler->addMessage(tag + "INFO " + msg);
+            pTMsgHandler->addMessage(TLog::text(t, msg));
             break;
         case QtWarningMsg:
-            pTMsgHandler->addMessage(tag + "WARN " + msg);
+            pTMsgHandler->addMessage(TLog::text(t, msg));
             break;
         case QtCriticalMsg:
-            pTMsgHandler->addMessage(tag + "CRIT " + msg);
+            pTMsgHandler->addMessage(TLog::text(t, msg));
             break;
         case QtFatalMsg:
-            pTMsgHandler->addMessage(tag + "FATL " + msg);
+            // the message list may be in use by the writer thread
+            fprintf(stderr, "%s FATL %s\n", qPrintable(tag), qPrintable(msg));
             abort();
         }
     }
@@ -11,7 +11,7 @@
 // 2023-1-18  tt  Initial version created
 // ***************************************************************************
 #include "tpowereventfilter.h"
-#include <QDebug>
+#include "logcategories.h"
 #include <QAbstractEventDispatcher>
 #include <QDebug>
 #include <windows.h>
@@ -32,22 +32,22 @@ bool TPowerEventFilter::nativeEventFilter(const QByteArray &eventType, void *mes
     if (msg->message == WM_POWERBROADCAST) {
         switch (msg->wParam) {
         case PBT_APMPOWERSTATUSCHANGE:
-            qDebug() << ("PBT_APMPOWERSTATUSCHANGE  received");
+            qCDebug(lcPower) << ("PBT_APMPOWERSTATUSCHANGE  received");
             emit PowerStatusChange();
             ret = true;
             break;
         case PBT_APMRESUMEAUTOMATIC:
-            qDebug() << ("PBT_APMRESUMEAUTOMATIC  received");
+            qCDebug(lcPower) << ("PBT_APMRESUMEAUTOMATIC  received");
             emit ResumeAutomatic();
             ret = true;
             break;
         case PBT_APMRESUMESUSPEND:
-            qDebug() << ("PBT_APMRESUMESUSPEND  received");
+            qCDebug(lcPower) << ("PBT_APMRESUMESUSPEND  received");
             emit ResumeSuspend();
             ret = true;
             break;
         case PBT_APMSUSPEND:
-            qDebug() << ("PBT_APMSUSPEND  received");
+            qCDebug(lcPower) << ("PBT_APMSUSPEND  received");
             emit Suspend();
             ret = true;
             break;
@@ -0,0 +1,181 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// tracecodec.h
+// streaming compression of recorded voltage / current traces
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Every sample is stored as zig-zag encoded varints (7 bits per byte, LSB
+// first):
+//   h        bit 0 = 0: h >> 1 is the zig-zag delta of the time delta
+//            bit 0 = 1: h >> 1 repetitions of the previous sample with
+//                       the same time delta, no further fields
+//   du << 1 | cc   zig-zag voltage delta and the CC flag
+//   di       zig-zag current delta
+// All deltas start from 0. Steady readings at a constant rate collapse into
+// a single run, a changing last digit costs 3 bytes per sample.
+// ***************************************************************************
+#ifndef TRACECODEC_H
+#define TRACECODEC_H
+
+#include <QByteArray>
+
+#define TRACE_MAGIC     "MP7100TR"
+#define TRACE_VERSION   1
+
+// file header of a compressed trace, followed by the encoded samples
+typedef struct {
+    char        magic[8];       // TRACE_MAGIC, not 0 terminated
+    quint32     version;
+    quint32     voltageScale;   // counts per volt
+    quint32     currentScale;   // counts per ampere
+    quint32     minU, minI;     // device limits in model units
+    quint32     maxU, maxI;
+    quint32     reserved;
+    qint64      startMs;        // wall clock time of t = 0 in ms since epoch (UTC)
+    quint64     count;          // number of samples
+} TRACE_HEADER;
+
+class TraceEncoder
+{
+public:
+    // encoded samples are appended to out
+    explicit TraceEncoder(QByteArray &out)
+        : m_out(out), m_t(0), m_dt(0), m_u(0), m_i(0), m_cc(false), m_run(0), m_count(0) {}
+
+    // t must not decrease
+    void append(quint32 tMs, quint16 u, quint16 i, bool cc)
+    {
+        const qint64 dt = static_cast<qint64>(tMs) - m_t;
+        if ((m_count > 0) && (dt == m_dt) && (u == m_u) && (i == m_i) && (cc == m_cc)) {
+            m_run++;
+        } else {
+            flush();
+            putVarint(zigzag(dt - m_dt) << 1);
+            putVarint((zigzag(static_cast<qint64>(u) - m_u) << 1) | (cc ? 1 : 0));
+            putVarint(zigzag(static_cast<qint64>(i) - m_i));
+            m_dt = dt;
+            m_u = u;
+            m_i = i;
+            m_cc = cc;
+        }
+        m_t = tMs;
+        m_count++;
+    }
+
+    // write a pending run, must be called after the last sample
+    void finish() { flush(); }
+    quint64 count() const { return m_count; }
+
+private:
+    static quint64 zigzag(qint64 v) { return (static_cast<quint64>(v) << 1) ^ static_cast<quint64>(v >> 63); }
+
+    void putVarint(quint64 v)
+    {
+        char buf[10];
+        int n = 0;
+        while (v >= 0x80) {
+            buf[n++] = static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = static_cast<char>(v);
+        m_out.append(buf, n);
+    }
+
+    void flush()
+    {
+        if (m_run > 0) {
+            putVarint((m_run << 1) | 1);
+            m_run = 0;
+        }
+    }
+
+    QByteArray  &m_out;
+    qint64      m_t, m_dt;
+    qint64      m_u, m_i;
+    bool        m_cc;
+    quint64     m_run;
+    quint64     m_count;
+};
+
+class TraceDecoder
+{
+public:
+    // data must stay valid while decoding
+    TraceDecoder(const char *data, qint64 size)
+        : m_p(reinterpret_cast<const uchar*>(data)), m_end(m_p + size)
+        , m_t(0), m_dt(0), m_u(0), m_i(0), m_cc(false), m_run(0), m_error(false) {}
+
+    // returns false at the end of the data or on a truncated stream
+    bool next(quint32 &tMs, quint16 &u, quint16 &i, bool &cc)
+    {
+        if (m_run == 0) {
+            if (m_p == m_end)
+                return false;
+            quint64 h;
+            if (!getVarint(h))
+                return false;
+            if (h & 1) {
+                m_run = h >> 1;
+            } else {
+                quint64 vu, vi;
+                if (!getVarint(vu) || !getVarint(vi))
+                    return false;
+                m_dt += unzigzag(h >> 1);
+                m_u += unzigzag(vu >> 1);
+                m_cc = (vu & 1) != 0;
+                m_i += unzigzag(vi);
+                m_run = 1;
+            }
+            if (m_run == 0)
+                return next(tMs, u, i, cc);
+        }
+        m_run--;
+        m_t += m_dt;
+        tMs = static_cast<quint32>(m_t);
+        u = static_cast<quint16>(m_u);
+        i = static_cast<quint16>(m_i);
+        cc = m_cc;
+        return true;
+    }
+
+    // true if the data ended inside a sample
+    bool hasError() const { return m_error; }
+
+private:
+    static qint64 unzigzag(quint64 v) { return static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1); }
+
+    bool getVarint(quint64 &v)
+    {
+        // most deltas fit into a single byte
+        if ((m_p != m_end) && (*m_p < 0x80)) {
+            v = *m_p++;
+            return true;
+        }
+        v = 0;
+        for (int shift = 0; (m_p != m_end) && (shift < 64); shift += 7) {
+            const uchar b = *m_p++;
+            v |= static_cast<quint64>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+        m_error = true;
+        m_p = m_end;
+        return false;
+    }
+
+    const uchar *m_p;
+    const uchar * const m_end;
+    qint64      m_t, m_dt;
+    qint64      m_u, m_i;
+    bool        m_cc;
+    quint64     m_run;
+    bool        m_error;
+};
+
+#endif // TRACECODEC_H
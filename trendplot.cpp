@@ -0,0 +1,222 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendplot.cpp
+// voltage and current trend plot widget
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "trendplot.h"
+#include <QPainter>
+#include <QTimerEvent>
+#include <QWheelEvent>
+
+// repaint at most every FRAME_MS (60 fps)
+#define FRAME_MS        16
+#define COLOR_BG        QColor(32, 32, 32)
+#define COLOR_GRID      QColor(72, 72, 72)
+#define COLOR_VOLTAGE   QColor(255, 200, 0)
+#define COLOR_CURRENT   QColor(0, 200, 255)
+
+// selectable time spans, 0 shows the complete history
+static const quint32 s_spans[] = { 10000, 60000, 600000, 3600000, 8*3600000, 0 };
+
+
+TrendPlot::TrendPlot(QWidget *parent)
+    : QWidget(parent)
+    , m_store(nullptr)
+    , m_lod(nullptr)
+    , m_spanMs(60000)
+    , m_idFrameTimer(0)
+    , m_uFull(0)
+    , m_iFull(0)
+    , m_cacheValid(false)
+    , m_msPerColumn(1)
+    , m_firstColumn(0)
+    , m_doneColumn(0)
+{
+    // the cached plot covers the whole widget
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setToolTip(tr("Use the mouse wheel to change the time span"));
+}
+
+TrendPlot::~TrendPlot()
+{
+    delete m_lod;
+}
+
+void TrendPlot::setStore(const SampleStore *store)
+{
+    delete m_lod;
+    m_store = store;
+    m_lod = (store != nullptr) ? new SampleLod(*store) : nullptr;
+    m_cacheValid = false;
+    update();
+}
+
+void TrendPlot::setSpan(quint32 ms)
+{
+    m_spanMs = ms;
+    m_cacheValid = false;
+    update();
+}
+
+void TrendPlot::samplesAppended()
+{
+    // collect all samples of a frame into a single repaint
+    if (m_idFrameTimer == 0)
+        m_idFrameTimer = startTimer(FRAME_MS, Qt::PreciseTimer);
+}
+
+void TrendPlot::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_idFrameTimer) {
+        killTimer(m_idFrameTimer);
+        m_idFrameTimer = 0;
+        update();
+    }
+}
+
+void TrendPlot::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_cacheValid = false;
+}
+
+void TrendPlot::wheelEvent(QWheelEvent *event)
+{
+    const int count = sizeof(s_spans)/sizeof(s_spans[0]);
+    int n = 0;
+    while ((n < count-1) && (s_spans[n] != m_spanMs))
+        ++n;
+    n = qBound(0, n + ((event->angleDelta().y() < 0) ? 1 : -1), count-1);
+    setSpan(s_spans[n]);
+    event->accept();
+}
+
+int TrendPlot::toY(int value, int fullScale) const
+{
+    const int h = height() - 1;
+    return h - static_cast<int>(static_cast<qint64>(qMin(value, fullScale))*h/fullScale);
+}
+
+bool TrendPlot::updateScale(const SampleLod::MINMAX &visible)
+{
+    // full scale is 1, 2 or 5 times a power of ten, it is only reduced if
+    // the visible values drop below a quarter to avoid redrawing too often
+    auto scale = [](int full, int max) {
+        if ((full > 0) && (max <= full) && (max*4 > full))
+            return full;
+        int s = 1;
+        for (;;) {
+            if (s >= max) return s;
+            if (2*s >= max) return 2*s;
+            if (5*s >= max) return 5*s;
+            s *= 10;
+        }
+    };
+    const int u = scale(m_uFull, qMax<int>(1, visible.uMax));
+    const int i = scale(m_iFull, qMax<int>(1, visible.iMax));
+    const bool changed = (u != m_uFull) || (i != m_iFull);
+    m_uFull = u;
+    m_iFull = i;
+    return changed;
+}
+
+void TrendPlot::renderColumns(qint64 from, qint64 to)
+{
+    QPainter p(&m_cache);
+    const int x0 = static_cast<int>(from - m_firstColumn);
+    p.fillRect(x0, 0, m_cache.width() - x0, m_cache.height(), COLOR_BG);
+    const SampleStore::RANGE all = m_store->all();
+    const QPen voltagePen(COLOR_VOLTAGE);
+    const QPen currentPen(COLOR_CURRENT);
+    for (qint64 c = qMax<qint64>(from, 0); c <= to; ++c) {
+        const quint32 t = static_cast<quint32>(c*m_msPerColumn);
+        const SampleStore::RANGE r = m_store->range(t, t + m_msPerColumn);
+        if (r.begin == r.end)
+            continue;
+        const SampleLod::MINMAX m = m_lod->aggregate(r.begin, r.end);
+        const int x = static_cast<int>(c - m_firstColumn);
+        // connect to the previous sample, which may lie some columns back
+        int xPrev = x;
+        quint64 prev = r.begin;
+        if (r.begin > all.begin) {
+            prev = r.begin - 1;
+            xPrev = static_cast<int>(m_store->timeMs(prev)/m_msPerColumn - m_firstColumn);
+        }
+        p.setPen(voltagePen);
+        p.drawLine(xPrev, toY(m_store->rawVoltage(prev), m_uFull), x, toY(m_store->rawVoltage(r.begin), m_uFull));
+        p.drawLine(x, toY(m.uMin, m_uFull), x, toY(m.uMax, m_uFull));
+        p.setPen(currentPen);
+        p.drawLine(xPrev, toY(m_store->rawCurrent(prev), m_iFull), x, toY(m_store->rawCurrent(r.begin), m_iFull));
+        p.drawLine(x, toY(m.iMin, m_iFull), x, toY(m.iMax, m_iFull));
+    }
+}
+
+QString TrendPlot::spanText() const
+{
+    const quint32 s = (m_spanMs != 0) ? m_spanMs/1000 : m_msPerColumn*width()/1000;
+    QString text = (s >= 3600) ? tr("%1 h").arg(s/3600.,0, 'f', 1)
+                               : (s >= 60) ? tr("%1 min").arg(s/60.,0, 'f', 1) : tr("%1 s").arg(s);
+    return (m_spanMs != 0) ? text : tr("all (%1)").arg(text);
+}
+
+void TrendPlot::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter p(this);
+    if ((m_store == nullptr) || m_store->isEmpty() || (width() < 2) || (height() < 2)) {
+        p.fillRect(rect(), COLOR_BG);
+        m_cacheValid = false;
+        return;
+    }
+    m_lod->update();
+    // columns are aligned to absolute time so that cached columns stay valid
+    const int w = width();
+    const quint32 lastMs = m_store->lastTimeMs();
+    const quint32 span = (m_spanMs != 0) ? m_spanMs : lastMs + 1;
+    const quint32 msPerColumn = qMax<quint32>(1, (span + w - 1)/w);
+    const qint64 lastColumn = lastMs/msPerColumn;
+    const qint64 firstColumn = lastColumn - w + 1;
+    const quint32 firstMs = static_cast<quint32>(qMax<qint64>(0, firstColumn*msPerColumn));
+    const SampleStore::RANGE visible = m_store->range(firstMs, lastMs + 1);
+    const bool rescaled = updateScale(m_lod->aggregate(visible.begin, visible.end));
+
+    qint64 from = qMax(m_doneColumn, firstColumn);
+    if (!m_cacheValid || rescaled || (m_cache.size() != size()) || (msPerColumn != m_msPerColumn)
+            || (firstColumn - m_firstColumn >= w) || (firstColumn < m_firstColumn)) {
+        if (m_cache.size() != size())
+            m_cache = QPixmap(size());
+        m_msPerColumn = msPerColumn;
+        from = firstColumn;
+        m_cacheValid = true;
+    } else if (firstColumn > m_firstColumn) {
+        m_cache.scroll(static_cast<int>(m_firstColumn - firstColumn), 0, m_cache.rect());
+    }
+    m_firstColumn = firstColumn;
+    renderColumns(from, lastColumn);
+    // the newest column is still filling and will be drawn again
+    m_doneColumn = lastColumn;
+    p.drawPixmap(0, 0, m_cache);
+
+    // grid and scale are drawn on top, they don't scroll
+    p.setPen(COLOR_GRID);
+    for (int n = 1; n < 4; ++n) {
+        const int y = n*(height()-1)/4;
+        p.drawLine(0, y, w-1, y);
+    }
+    const MP7100Protocol::MODEL &model = m_store->model();
+    p.setPen(COLOR_VOLTAGE);
+    p.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop,
+               tr("%1 V").arg(static_cast<double>(m_uFull)/model.voltageScale));
+    p.setPen(COLOR_CURRENT);
+    p.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignRight | Qt::AlignTop,
+               tr("%1 A").arg(static_cast<double>(m_iFull)/model.currentScale));
+    p.setPen(Qt::lightGray);
+    p.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignBottom, spanText());
+}
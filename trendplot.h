@@ -0,0 +1,69 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// trendplot.h
+// voltage and current trend plot widget, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Every pixel column shows minimum and maximum of its samples, taken from a
+// SampleLod, so drawing costs depend on the width only. The plot is kept in
+// a pixmap which is scrolled as time advances, only the new columns are
+// drawn. The mouse wheel changes the visible time span.
+// ***************************************************************************
+#ifndef TRENDPLOT_H
+#define TRENDPLOT_H
+
+#include <QWidget>
+#include <QPixmap>
+#include "samplestore.h"
+#include "samplelod.h"
+
+class TrendPlot : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TrendPlot(QWidget *parent = nullptr);
+    ~TrendPlot();
+
+    // the store must outlive the plot
+    void setStore(const SampleStore *store);
+    // visible time span, 0 shows the complete history
+    void setSpan(quint32 ms);
+    quint32 span() const { return m_spanMs; }
+
+public slots:
+    // repaint at the next frame
+    void samplesAppended();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    bool updateScale(const SampleLod::MINMAX &visible);
+    void renderColumns(qint64 from, qint64 to);
+    int toY(int value, int fullScale) const;
+    QString spanText() const;
+
+    const SampleStore   *m_store;
+    SampleLod           *m_lod;
+    quint32             m_spanMs;
+    int                 m_idFrameTimer;
+    // full scale of the plot in model units
+    int                 m_uFull, m_iFull;
+    // plot cache, column c covers the times [c*m_msPerColumn, (c+1)*m_msPerColumn)
+    QPixmap             m_cache;
+    bool                m_cacheValid;
+    quint32             m_msPerColumn;
+    qint64              m_firstColumn;  // column at x = 0
+    qint64              m_doneColumn;   // columns before are final
+};
+
+#endif // TRENDPLOT_H
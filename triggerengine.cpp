@@ -0,0 +1,77 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// triggerengine.cpp
+// threshold and transition triggers on the measured samples
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "triggerengine.h"
+
+TriggerEngine::TriggerEngine()
+    : m_hasLastCC(false)
+    , m_lastCC(false)
+{
+}
+
+void TriggerEngine::arm(const TRIGGER &trigger)
+{
+    disarm(trigger.id);
+    ARMED a;
+    a.trigger = trigger;
+    // a transition is a single sample
+    const bool transition = (trigger.condition == EnterCC) || (trigger.condition == LeaveCC);
+    a.trigger.samples = transition ? 1 : qMax(1, trigger.samples);
+    a.count = 0;
+    m_triggers.append(a);
+    // the CC state may be stale, it is only tracked while triggers are armed
+    m_hasLastCC = false;
+}
+
+void TriggerEngine::disarm(int id)
+{
+    for (int n = m_triggers.size()-1; n >= 0; --n) {
+        if (m_triggers.at(n).trigger.id == id)
+            m_triggers.removeAt(n);
+    }
+}
+
+void TriggerEngine::reset()
+{
+    m_hasLastCC = false;
+    for (ARMED &a : m_triggers)
+        a.count = 0;
+}
+
+int TriggerEngine::evaluate(double u, double i, bool cc, QVector<FIRED> &fired)
+{
+    // transitions need the previous state, the first sample can't be one
+    const bool enterCC = m_hasLastCC && !m_lastCC && cc;
+    const bool leaveCC = m_hasLastCC && m_lastCC && !cc;
+    m_hasLastCC = true;
+    m_lastCC = cc;
+    int actions = 0;
+    for (int n = m_triggers.size()-1; n >= 0; --n) {
+        ARMED &a = m_triggers[n];
+        bool met = false;
+        switch (a.trigger.condition) {
+        case CurrentAbove:  met = i > a.trigger.level; break;
+        case CurrentBelow:  met = i < a.trigger.level; break;
+        case VoltageAbove:  met = u > a.trigger.level; break;
+        case VoltageBelow:  met = u < a.trigger.level; break;
+        case EnterCC:       met = enterCC; break;
+        case LeaveCC:       met = leaveCC; break;
+        }
+        a.count = met ? a.count + 1 : 0;
+        if (a.count >= a.trigger.samples) {
+            fired.append({ a.trigger.id, a.trigger.actions });
+            actions |= a.trigger.actions;
+            m_triggers.removeAt(n);
+        }
+    }
+    return actions;
+}
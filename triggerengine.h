@@ -0,0 +1,79 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// triggerengine.h
+// threshold and transition triggers on the measured samples, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Triggers are evaluated by MP7100 in the device thread as soon as a reply
+// has been decoded. Every trigger fires once and is disarmed afterwards.
+// ***************************************************************************
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include <QtGlobal>
+#include <QVector>
+
+class TriggerEngine
+{
+public:
+    typedef enum {
+        CurrentAbove,       // current > level for samples consecutive samples
+        CurrentBelow,
+        VoltageAbove,
+        VoltageBelow,
+        EnterCC,            // CV -> CC transition
+        LeaveCC             // CC -> CV transition
+    } CONDITION;
+
+    // actions of a trigger, may be combined
+    typedef enum {
+        ActionOutputOff = 0x01, // switched off by MP7100 itself
+        ActionMark      = 0x02, // left to the receiver of MP7100::triggerFired()
+        ActionSnapshot  = 0x04
+    } ACTION;
+
+    typedef struct {
+        int         id;         // chosen by the caller, arming the same id again replaces the trigger
+        CONDITION   condition;
+        double      level;      // V or A, unused for transitions
+        int         samples;    // consecutive samples required, unused for transitions
+        int         actions;    // ACTION flags
+    } TRIGGER;
+
+    // id and actions of a fired trigger
+    typedef struct {
+        int         id;
+        int         actions;
+    } FIRED;
+
+    TriggerEngine();
+
+    // the CC state of the samples before is not used for transitions
+    void arm(const TRIGGER &trigger);
+    void disarm(int id);
+    // an invalid sample or a timeout breaks transitions and consecutive samples
+    void reset();
+    bool isEmpty() const { return m_triggers.isEmpty(); }
+
+    // evaluate a valid sample, fired triggers are appended to fired and
+    // disarmed; returns the combined actions of all fired triggers
+    int evaluate(double u, double i, bool cc, QVector<FIRED> &fired);
+
+private:
+    typedef struct {
+        TRIGGER     trigger;
+        int         count;      // consecutive samples meeting the condition
+    } ARMED;
+
+    QVector<ARMED>  m_triggers;
+    bool            m_hasLastCC;
+    bool            m_lastCC;
+};
+
+#endif // TRIGGERENGINE_H
@@ -0,0 +1,61 @@
+// ***************************************************************************
+// General Support Classes
+// ---------------------------------------------------------------------------
+// tspscqueue.h
+// bounded lock-free single producer / single consumer queue
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// push() must only be called from one thread and pop() from one (other)
+// thread. N must be a power of 2. Items are copied into preallocated slots,
+// so no memory is allocated for trivially copyable types.
+// ***************************************************************************
+#ifndef TSPSCQUEUE_H
+#define TSPSCQUEUE_H
+
+#include <QAtomicInteger>
+
+template<typename T, int N>
+class TSpscQueue
+{
+    static_assert((N > 0) && ((N & (N-1)) == 0), "N must be a power of 2");
+
+public:
+    TSpscQueue() : m_head(0), m_tail(0) {}
+
+    // producer side, returns false if the queue is full
+    bool push(const T &item)
+    {
+        const quint32 head = m_head.loadRelaxed();
+        if (head - m_tail.loadAcquire() >= static_cast<quint32>(N))
+            return false;
+        m_items[head & (N-1)] = item;
+        m_head.storeRelease(head + 1);
+        return true;
+    }
+
+    // consumer side, returns false if the queue is empty
+    bool pop(T &item)
+    {
+        const quint32 tail = m_tail.loadRelaxed();
+        if (m_head.loadAcquire() == tail)
+            return false;
+        item = m_items[tail & (N-1)];
+        m_tail.storeRelease(tail + 1);
+        return true;
+    }
+
+    bool isEmpty() const { return m_head.loadAcquire() == m_tail.loadAcquire(); }
+
+private:
+    T                                   m_items[N];
+    // keep producer and consumer index on separate cache lines
+    alignas(64) QAtomicInteger<quint32> m_head;
+    alignas(64) QAtomicInteger<quint32> m_tail;
+};
+
+#endif // TSPSCQUEUE_H
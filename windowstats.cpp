@@ -0,0 +1,121 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// windowstats.cpp
+// sliding window statistics of voltage, current and power
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ***************************************************************************
+#include "windowstats.h"
+#include <cmath>
+
+WindowStats::WindowStats(qint64 windowMs)
+    : m_windowNs(windowMs*1000000)
+    , m_seq(0)
+    , m_removed(0)
+{
+    clear();
+}
+
+void WindowStats::clear()
+{
+    m_samples.clear();
+    for (auto &a : m_accu) {
+        a.mean = 0.;
+        a.m2 = 0.;
+        a.minQueue.clear();
+        a.maxQueue.clear();
+    }
+    m_removed = 0;
+}
+
+void WindowStats::add(qint64 tNs, double u, double i)
+{
+    while (!m_samples.isEmpty() && (tNs - m_samples.front().tNs >= m_windowNs)) {
+        remove(m_samples.front());
+        m_samples.popFront();
+    }
+    SAMPLE s;
+    s.tNs = tNs;
+    s.seq = m_seq++;
+    s.v[Voltage] = u;
+    s.v[Current] = i;
+    s.v[Power] = u*i;
+    m_samples.pushBack(s);
+    const int n = m_samples.size();
+    for (int q = 0; q < QuantityCount; ++q) {
+        ACCU &a = m_accu[q];
+        const double x = s.v[q];
+        const double d = x - a.mean;
+        a.mean += d/n;
+        a.m2 += d*(x - a.mean);
+        // values that can't become the minimum / maximum anymore are dropped
+        while (!a.minQueue.isEmpty() && (a.minQueue.back().v[q] >= x))
+            a.minQueue.popBack();
+        a.minQueue.pushBack(s);
+        while (!a.maxQueue.isEmpty() && (a.maxQueue.back().v[q] <= x))
+            a.maxQueue.popBack();
+        a.maxQueue.pushBack(s);
+    }
+}
+
+void WindowStats::remove(const SAMPLE &s)
+{
+    const int n = m_samples.size() - 1;
+    for (int q = 0; q < QuantityCount; ++q) {
+        ACCU &a = m_accu[q];
+        if (n == 0) {
+            a.mean = 0.;
+            a.m2 = 0.;
+        } else {
+            const double x = s.v[q];
+            const double d = x - a.mean;
+            a.mean -= d/n;
+            a.m2 = qMax(0., a.m2 - d*(x - a.mean));
+        }
+        if (!a.minQueue.isEmpty() && (a.minQueue.front().seq == s.seq))
+            a.minQueue.popFront();
+        if (!a.maxQueue.isEmpty() && (a.maxQueue.front().seq == s.seq))
+            a.maxQueue.popFront();
+    }
+    if (++m_removed >= m_samples.size())
+        recompute();
+}
+
+void WindowStats::recompute()
+{
+    // the sample being removed is still the first one of m_samples
+    m_removed = 0;
+    const int count = m_samples.size();
+    for (int q = 0; q < QuantityCount; ++q) {
+        ACCU &a = m_accu[q];
+        a.mean = 0.;
+        a.m2 = 0.;
+        for (int n = 1; n < count; ++n) {
+            const double x = m_samples.at(n).v[q];
+            const double d = x - a.mean;
+            a.mean += d/n;
+            a.m2 += d*(x - a.mean);
+        }
+    }
+}
+
+WindowStats::RESULT WindowStats::result(QUANTITY q) const
+{
+    const ACCU &a = m_accu[q];
+    RESULT r;
+    r.count = m_samples.size();
+    if (r.count == 0) {
+        r.min = r.max = r.mean = r.stddev = 0.;
+        return r;
+    }
+    r.min = a.minQueue.front().v[q];
+    r.max = a.maxQueue.front().v[q];
+    r.mean = a.mean;
+    r.stddev = (r.count > 1) ? std::sqrt(a.m2/(r.count - 1)) : 0.;
+    return r;
+}
@@ -0,0 +1,108 @@
+// ***************************************************************************
+// MP7100xx power supply serial control tool
+// ---------------------------------------------------------------------------
+// windowstats.h
+// sliding window statistics of voltage, current and power, header file
+// ---------------------------------------------------------------------------
+// Copyright (C) 2026 by t2ft - Thomas Thanner
+// Waldstrasse 15, 86399 Bobingen, Germany
+// thomas@t2ft.de
+// ---------------------------------------------------------------------------
+// 2026-10-17  tt  Initial version created
+// ---------------------------------------------------------------------------
+// Mean and variance are updated with Welford's algorithm when a sample
+// enters or leaves the window, minimum and maximum with monotonic deques.
+// Every sample costs amortized O(1), independent of the window length. The
+// sums are recomputed from the window contents whenever it has been replaced
+// completely, so rounding errors of the removals can't accumulate.
+// ***************************************************************************
+#ifndef WINDOWSTATS_H
+#define WINDOWSTATS_H
+
+#include <QtGlobal>
+#include <QVector>
+
+class WindowStats
+{
+public:
+    typedef enum {
+        Voltage,
+        Current,
+        Power,
+        QuantityCount
+    } QUANTITY;
+
+    typedef struct {
+        int     count;
+        double  min;
+        double  max;
+        double  mean;
+        double  stddev;
+    } RESULT;
+
+    explicit WindowStats(qint64 windowMs);
+
+    // tNs is a monotonic host time, samples older than the window are dropped
+    void add(qint64 tNs, double u, double i);
+    void clear();
+    qint64 windowMs() const { return m_windowNs/1000000; }
+    int count() const { return m_samples.size(); }
+    RESULT result(QUANTITY q) const;
+
+private:
+    // growing ring buffer, used as a deque
+    template<typename T>
+    class Ring
+    {
+    public:
+        Ring() : m_data(16), m_head(0), m_size(0) {}
+        int size() const { return m_size; }
+        bool isEmpty() const { return m_size == 0; }
+        const T &at(int n) const { return m_data[(m_head + n) & (m_data.size()-1)]; }
+        const T &front() const { return at(0); }
+        const T &back() const { return at(m_size-1); }
+        void popFront() { m_head = (m_head + 1) & (m_data.size()-1); m_size--; }
+        void popBack() { m_size--; }
+        void clear() { m_head = 0; m_size = 0; }
+        void pushBack(const T &item)
+        {
+            if (m_size == m_data.size()) {
+                QVector<T> data(2*m_data.size());
+                for (int n = 0; n < m_size; ++n)
+                    data[n] = at(n);
+                m_data.swap(data);
+                m_head = 0;
+            }
+            m_data[(m_head + m_size) & (m_data.size()-1)] = item;
+            m_size++;
+        }
+    private:
+        QVector<T>  m_data;     // size is a power of 2
+        int         m_head;
+        int         m_size;
+    };
+
+    typedef struct {
+        qint64  tNs;
+        quint64 seq;
+        double  v[QuantityCount];
+    } SAMPLE;
+
+    typedef struct {
+        double  mean;
+        double  m2;             // sum of squared differences from the mean
+        Ring<SAMPLE> minQueue;  // increasing values, front is the minimum
+        Ring<SAMPLE> maxQueue;  // decreasing values, front is the maximum
+    } ACCU;
+
+    void remove(const SAMPLE &s);
+    void recompute();
+
+    const qint64    m_windowNs;
+    Ring<SAMPLE>    m_samples;
+    ACCU            m_accu[QuantityCount];
+    quint64         m_seq;      // sequence number of the next sample
+    int             m_removed;  // removals since the last recompute()
+};
+
+#endif // WINDOWSTATS_H